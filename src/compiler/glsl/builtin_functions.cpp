@@ -39,7 +39,8 @@
  *
  *    The builtin_builder::create_builtins() function contains lists of all
  *    built-in function signatures, where they're available, what types they
- *    take, and so on.
+ *    take, and so on.  Only the names are registered up front; the
+ *    signatures of a function are generated the first time it is looked up.
  *
  * 4. Implementations of built-in function signatures
  *
@@ -87,6 +88,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #ifndef M_PIf
 #define M_PIf   ((float) M_PI)
@@ -1165,13 +1167,21 @@ public:
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, ir_exec_list *actual_parameters);
 
+   /**
+    * Return the built-in function called \p name, generating its signatures
+    * if this is the first lookup of it, or NULL if there is no such
+    * built-in.
+    */
+   ir_function *get_function(const char *name);
+
    /**
     * A symbol table to hold all the built-in signatures; created by this
     * module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in looked up so far,
+    * regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature()
+    * to filter out the irrelevant ones.
     */
    struct glsl_symbol_table *symbols;
 
@@ -1179,6 +1189,17 @@ private:
    void *mem_ctx;
    linear_ctx *linalloc;
 
+   /** Names of all the functions create_builtins() can add. */
+   struct set *function_names;
+
+   /**
+    * The function create_builtins() should add, or NULL to only record the
+    * names in \c function_names.
+    */
+   const char *wanted_function;
+
+   bool want_function(const char *name);
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
@@ -1633,6 +1654,8 @@ builtin_builder::builtin_builder()
 {
    mem_ctx = NULL;
    linalloc = NULL;
+   function_names = NULL;
+   wanted_function = NULL;
 }
 
 builtin_builder::~builtin_builder()
@@ -1643,6 +1666,7 @@ builtin_builder::~builtin_builder()
    mem_ctx = NULL;
    linalloc = NULL;
    symbols = NULL;
+   function_names = NULL;
 
    simple_mtx_unlock(&builtins_lock);
 }
@@ -1660,7 +1684,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1675,6 +1699,31 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   ir_function *f = symbols->get_function(name);
+   if (f != NULL || _mesa_set_search(function_names, name) == NULL)
+      return f;
+
+   wanted_function = name;
+   create_builtins();
+   wanted_function = NULL;
+
+   return symbols->get_function(name);
+}
+
+bool
+builtin_builder::want_function(const char *name)
+{
+   if (wanted_function == NULL) {
+      _mesa_set_add(function_names, name);
+      return false;
+   }
+
+   return strcmp(name, wanted_function) == 0;
+}
+
 void
 builtin_builder::initialize()
 {
@@ -1686,8 +1735,17 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    linalloc = linear_context(mem_ctx);
+   function_names = _mesa_set_create(mem_ctx, _mesa_hash_string,
+                                     _mesa_key_string_equal);
    create_shader();
    create_intrinsics();
+
+   /* Intrinsics are referenced from the built-in bodies, so they are all
+    * generated here.  For the built-ins themselves, only the names are
+    * recorded; generating the IR for every signature of every built-in
+    * takes most of the time of the first compile, while a typical shader
+    * only calls a handful of them.
+    */
    create_builtins();
 }
 
@@ -1698,6 +1756,7 @@ builtin_builder::release()
    mem_ctx = NULL;
    linalloc = NULL;
    symbols = NULL;
+   function_names = NULL;
 
    glsl_type_singleton_decref();
 }
@@ -2082,11 +2141,19 @@ builtin_builder::create_intrinsics()
 /**
  * Create ir_function and ir_function_signature objects for each built-in.
  *
- * Contains a list of every available built-in.
+ * Contains a list of every available built-in.  Only the function selected
+ * by want_function() is actually created; the signature arguments of the
+ * others are never evaluated.
  */
 void
 builtin_builder::create_builtins()
 {
+#define add_function(NAME, ...)                 \
+   do {                                         \
+      if (want_function(NAME))                  \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 #define F(NAME)                                 \
    add_function(#NAME,                          \
                 _##NAME(&glsl_type_builtin_float), \
@@ -6047,6 +6114,7 @@ builtin_builder::create_builtins()
 #undef FIUDHF_VEC
 #undef FIUBDHF_VEC
 #undef FIU2_MIXED
+#undef add_function
 }
 
 void
@@ -6119,6 +6187,10 @@ builtin_builder::add_image_function(const char *name,
       &glsl_type_builtin_uimage2DMSArray
    };
 
+   /* The GLSL-facing variants are created lazily like other built-ins. */
+   if ((flags & IMAGE_FUNCTION_EMIT_STUB) && !want_function(name))
+      return;
+
    ir_function *f = new(linalloc) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -9614,7 +9686,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    simple_mtx_lock(&builtins_lock);
-   f = builtins.symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       ir_foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -9628,10 +9700,15 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    return ret;
 }
 
-struct glsl_symbol_table *
-_mesa_glsl_get_builtin_function_symbols()
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
 {
-   return builtins.symbols;
+   ir_function *f;
+   simple_mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   simple_mtx_unlock(&builtins_lock);
+
+   return f;
 }
 
 
@@ -1409,12 +1409,57 @@ lower_shared_memory(const struct gl_constants *consts,
    return true;
 }
 
+struct prelink_state {
+   const struct pipe_screen *screen;
+   const struct gl_constants *consts;
+   const struct gl_extensions *exts;
+   struct gl_shader_program *shader_program;
+};
+
+static void
+prelink_preprocess_stage(struct gl_linked_shader *shader, void *data)
+{
+   const struct prelink_state *state = (const struct prelink_state *)data;
+   const nir_shader_compiler_options *options =
+      state->screen->nir_options[shader->Stage];
+
+   preprocess_shader(state->screen, state->consts, state->exts,
+                     shader->Program, state->shader_program, shader->Stage);
+
+   if (options->lower_to_scalar) {
+      NIR_PASS(_, shader->Program->nir, nir_lower_load_const_to_scalar);
+   }
+}
+
+static void
+prelink_lower_access_and_clip_cull(struct gl_linked_shader *shader,
+                                   UNUSED void *data)
+{
+   nir_shader *nir = shader->Program->nir;
+
+   nir_opt_access_options opt_access_options;
+   opt_access_options.is_vulkan = false;
+   NIR_PASS(_, nir, nir_opt_access, &opt_access_options);
+
+   /* This must be done before calling nir_lower_clip_cull_distance_to_vec4s. */
+   nir_gather_clip_cull_distance_sizes_from_vars(nir);
+
+   if (!nir->options->compact_arrays) {
+      NIR_PASS(_, nir, nir_lower_clip_cull_distance_to_vec4s);
+      NIR_PASS(_, nir, nir_lower_tess_level_array_vars_to_vec);
+   }
+
+   /* Combine clip and cull outputs into one array. */
+   NIR_PASS(_, nir, nir_merge_clip_cull_distance_vars);
+}
+
 static bool
 prelink_lowering(const struct pipe_screen *screen,
                  const struct gl_constants *consts,
                  const struct gl_extensions *exts,
                  struct gl_shader_program *shader_program,
-                 struct gl_linked_shader **linked_shader, unsigned num_shaders)
+                 struct gl_linked_shader **linked_shader, unsigned num_shaders,
+                 struct util_queue *queue)
 {
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
@@ -1435,14 +1480,18 @@ prelink_lowering(const struct pipe_screen *screen,
       if (shader_program->IsES && shader_program->GLSL_Version >= 300 &&
           i == MESA_SHADER_VERTEX)
          remove_dead_varyings_pre_linking(prog->nir);
-
-      preprocess_shader(screen, consts, exts, prog, shader_program, shader->Stage);
-
-      if (options->lower_to_scalar) {
-         NIR_PASS(_, shader->Program->nir, nir_lower_load_const_to_scalar);
-      }
    }
 
+   /* The stages are independent until they are linked together. */
+   struct prelink_state state = {
+      .screen = screen,
+      .consts = consts,
+      .exts = exts,
+      .shader_program = shader_program,
+   };
+   link_util_run_per_stage(queue, linked_shader, num_shaders,
+                           prelink_preprocess_stage, &state);
+
    lower_patch_vertices_in(shader_program);
 
    /* Linking shaders also optimizes them. Separate shaders, compute shaders
@@ -1473,24 +1522,8 @@ prelink_lowering(const struct pipe_screen *screen,
    /* nir_opt_access() needs to run before linking so that ImageAccess[]
     * and BindlessImage[].access are filled out with the correct modes.
     */
-   for (unsigned i = 0; i < num_shaders; i++) {
-      nir_shader *nir = linked_shader[i]->Program->nir;
-
-      nir_opt_access_options opt_access_options;
-      opt_access_options.is_vulkan = false;
-      NIR_PASS(_, nir, nir_opt_access, &opt_access_options);
-
-      /* This must be done before calling nir_lower_clip_cull_distance_to_vec4s. */
-      nir_gather_clip_cull_distance_sizes_from_vars(nir);
-
-      if (!nir->options->compact_arrays) {
-         NIR_PASS(_, nir, nir_lower_clip_cull_distance_to_vec4s);
-         NIR_PASS(_, nir, nir_lower_tess_level_array_vars_to_vec);
-      }
-
-      /* Combine clip and cull outputs into one array. */
-      NIR_PASS(_, nir, nir_merge_clip_cull_distance_vars);
-   }
+   link_util_run_per_stage(queue, linked_shader, num_shaders,
+                           prelink_lower_access_and_clip_cull, NULL);
 
    return true;
 }
@@ -1577,7 +1610,8 @@ gl_nir_link_spirv(const struct pipe_screen *screen,
 
    gl_nir_link_assign_xfb_resources(consts, prog);
 
-   if (!prelink_lowering(screen, consts, exts, prog, linked_shader, num_shaders))
+   if (!prelink_lowering(screen, consts, exts, prog, linked_shader, num_shaders,
+                         NULL))
       return false;
 
    gl_nir_lower_optimize_varyings(consts, prog, true);
@@ -3764,6 +3798,50 @@ validate_geometry_shader_executable(struct gl_shader_program *prog,
    analyze_clip_cull_usage(prog, shader, consts, &shader->info);
 }
 
+static void
+inline_stage_functions(struct gl_linked_shader *shader, void *data)
+{
+   gl_nir_inline_functions((const struct pipe_caps *)data,
+                           shader->Program->nir);
+}
+
+static void
+remove_dead_uniforms(struct gl_linked_shader *shader, void *data)
+{
+   const struct gl_constants *consts = (const struct gl_constants *)data;
+   nir_shader *nir = shader->Program->nir;
+
+   if (consts->GLSLLowerConstArrays) {
+      nir_lower_const_arrays_to_uniforms(nir,
+                                         consts->Program[shader->Stage].MaxUniformComponents);
+   }
+
+   const nir_remove_dead_variables_options opts = {
+      .can_remove_var = can_remove_var,
+   };
+   nir_remove_dead_variables(nir,
+                             nir_var_uniform | nir_var_image |
+                             nir_var_mem_ubo | nir_var_mem_ssbo |
+                             nir_var_system_value,
+                             &opts);
+
+   if (shader->Program->info.stage == MESA_SHADER_FRAGMENT) {
+      nir_foreach_variable_in_shader(var, nir) {
+         if (var->data.mode == nir_var_system_value &&
+             (var->data.location == SYSTEM_VALUE_SAMPLE_ID ||
+              var->data.location == SYSTEM_VALUE_SAMPLE_POS))
+            nir->info.fs.uses_sample_shading = true;
+
+         if (var->data.mode == nir_var_shader_in && var->data.sample)
+            nir->info.fs.uses_sample_shading = true;
+
+         if (var->data.mode == nir_var_shader_out &&
+             var->data.fb_fetch_output)
+            nir->info.fs.uses_sample_shading = true;
+      }
+   }
+}
+
 bool
 gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -3776,6 +3854,7 @@ gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
 
    MESA_TRACE_FUNC();
 
+   struct util_queue *queue = link_util_get_stage_queue(ctx);
    void *mem_ctx = ralloc_context(NULL); /* temporary linker context */
 
    /* Separate the shaders into groups based on their type.
@@ -3979,6 +4058,9 @@ gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
    if (!prog->data->LinkStatus)
       goto done;
 
+   struct gl_linked_shader *inline_shader[MESA_SHADER_MESH_STAGES];
+   unsigned num_inline_shaders = 0;
+
    for (unsigned i = 0; i < MESA_SHADER_MESH_STAGES; i++) {
       if (prog->_LinkedShaders[i] == NULL)
          continue;
@@ -3988,10 +4070,12 @@ gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
       if (!prog->data->LinkStatus)
          goto done;
 
-      gl_nir_inline_functions(&ctx->screen->caps,
-                              prog->_LinkedShaders[i]->Program->nir);
+      inline_shader[num_inline_shaders++] = prog->_LinkedShaders[i];
    }
 
+   link_util_run_per_stage(queue, inline_shader, num_inline_shaders,
+                           inline_stage_functions, (void *)&ctx->screen->caps);
+
    resize_tes_inputs(consts, prog);
    set_geom_shader_input_array_size(prog);
 
@@ -4139,7 +4223,7 @@ gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
       goto done;
 
    if (!prelink_lowering(ctx->screen, consts, exts, prog, linked_shader,
-                         num_linked_shaders))
+                         num_linked_shaders, queue))
       goto done;
 
    if (!gl_nir_link_varyings(ctx->screen, consts, exts, api, prog))
@@ -4165,41 +4249,8 @@ gl_nir_link_glsl(struct gl_context *ctx, struct gl_shader_program *prog)
    if (num_linked_shaders == 1)
       gl_nir_opts(linked_shader[0]->Program->nir);
 
-   for (unsigned i = 0; i < MESA_SHADER_MESH_STAGES; i++) {
-      struct gl_linked_shader *shader = prog->_LinkedShaders[i];
-      if (shader) {
-         if (consts->GLSLLowerConstArrays) {
-            nir_lower_const_arrays_to_uniforms(shader->Program->nir,
-                                               consts->Program[i].MaxUniformComponents);
-         }
-
-         const nir_remove_dead_variables_options opts = {
-            .can_remove_var = can_remove_var,
-         };
-         nir_remove_dead_variables(shader->Program->nir,
-                                   nir_var_uniform | nir_var_image |
-                                   nir_var_mem_ubo | nir_var_mem_ssbo |
-                                   nir_var_system_value,
-                                   &opts);
-
-         if (shader->Program->info.stage == MESA_SHADER_FRAGMENT) {
-            nir_shader *nir = shader->Program->nir;
-            nir_foreach_variable_in_shader(var, nir) {
-               if (var->data.mode == nir_var_system_value &&
-                   (var->data.location == SYSTEM_VALUE_SAMPLE_ID ||
-                    var->data.location == SYSTEM_VALUE_SAMPLE_POS))
-                  nir->info.fs.uses_sample_shading = true;
-
-               if (var->data.mode == nir_var_shader_in && var->data.sample)
-                  nir->info.fs.uses_sample_shading = true;
-
-               if (var->data.mode == nir_var_shader_out &&
-                   var->data.fb_fetch_output)
-                  nir->info.fs.uses_sample_shading = true;
-            }
-         }
-      }
-   }
+   link_util_run_per_stage(queue, linked_shader, num_linked_shaders,
+                           remove_dead_uniforms, (void *)consts);
 
    if (!gl_nir_link_uniform_blocks(consts, prog))
       goto done;
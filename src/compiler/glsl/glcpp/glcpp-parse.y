@@ -121,6 +121,12 @@ _parser_active_list_pop(glcpp_parser_t *parser);
 static int
 _parser_active_list_contains(glcpp_parser_t *parser, const char *identifier);
 
+static void
+_parser_add_macro_prefix(glcpp_parser_t *parser, const char *identifier);
+
+static bool
+_parser_may_be_macro(glcpp_parser_t *parser, const char *identifier);
+
 typedef enum {
    EXPANSION_MODE_IGNORE_DEFINED,
    EXPANSION_MODE_EVALUATE_DEFINED
@@ -373,6 +379,7 @@ control_line_success:
          /* Create a temporary parser with the same settings */
          glcpp_parser_t *tmp_parser =
             glcpp_parser_create(parser->gl_ctx, parser->extensions, parser->state);
+         tmp_parser->identifiers = parser->identifiers;
          tmp_parser->version_set = true;
          tmp_parser->version = parser->version;
 
@@ -1518,6 +1525,8 @@ glcpp_parser_create(struct gl_context *gl_ctx,
    parser->defines = _mesa_hash_table_create(NULL, _mesa_hash_string,
                                              _mesa_key_string_equal);
    parser->linalloc = linear_context(parser);
+   parser->identifiers = glcpp_identifiers_create(parser);
+   BITSET_ZERO(parser->macro_prefixes);
    parser->active = NULL;
    parser->lexing_directive = 0;
    parser->lexing_version_directive = 0;
@@ -2036,6 +2045,11 @@ _glcpp_parser_expand_node(glcpp_parser_t *parser, token_node_t *node,
                                                     node->token->location.source);
    }
 
+   /* Most identifiers in a shader are not macros, skip the lookup for the
+    * ones that can't be. */
+   if (!_parser_may_be_macro(parser, identifier))
+      return NULL;
+
    /* Look up this identifier in the hash table. */
    entry = _mesa_hash_table_search(parser->defines, identifier);
    macro = entry ? entry->data : NULL;
@@ -2127,6 +2141,26 @@ _parser_active_list_contains(glcpp_parser_t *parser, const char *identifier)
    return 0;
 }
 
+static unsigned
+_macro_prefix_index(const char *identifier)
+{
+   /* Identifiers are ASCII, and a one-character name has '\0' as its
+    * second character. */
+   return ((identifier[0] & 0x7f) << 7) | (identifier[1] & 0x7f);
+}
+
+static void
+_parser_add_macro_prefix(glcpp_parser_t *parser, const char *identifier)
+{
+   BITSET_SET(parser->macro_prefixes, _macro_prefix_index(identifier));
+}
+
+static bool
+_parser_may_be_macro(glcpp_parser_t *parser, const char *identifier)
+{
+   return BITSET_TEST(parser->macro_prefixes, _macro_prefix_index(identifier));
+}
+
 /* Walk over the token list replacing nodes with their expansion.
  * Whenever nodes are expanded the walking will walk over the new
  * nodes, continuing to expand as necessary. The results are placed in
@@ -2317,6 +2351,7 @@ _define_object_macro(glcpp_parser_t *parser, YYLTYPE *loc,
    }
 
    _mesa_hash_table_insert (parser->defines, identifier, macro);
+   _parser_add_macro_prefix(parser, identifier);
 }
 
 void
@@ -2352,6 +2387,7 @@ _define_function_macro(glcpp_parser_t *parser, YYLTYPE *loc,
    }
 
    _mesa_hash_table_insert(parser->defines, identifier, macro);
+   _parser_add_macro_prefix(parser, identifier);
 }
 
 static int
@@ -2396,7 +2432,8 @@ glcpp_parser_lex(YYSTYPE *yylval, YYLTYPE *yylloc, glcpp_parser_t *parser)
                ret == IFDEF || ret == IFNDEF || ret == ELIF || ret == ELSE ||
                ret == ENDIF || ret == HASH_TOKEN) {
          parser->in_control_line = 1;
-      } else if (ret == IDENTIFIER) {
+      } else if (ret == IDENTIFIER &&
+                 _parser_may_be_macro(parser, yylval->str)) {
          struct hash_entry *entry = _mesa_hash_table_search(parser->defines,
                                                             yylval->str);
          macro_t *macro = entry ? entry->data : NULL;
@@ -2606,4 +2643,5 @@ glcpp_parser_copy_defines(const void *key, void *data, void *closure)
    }
 
    _mesa_hash_table_insert(di->parser->defines, identifier, macro);
+   _parser_add_macro_prefix(di->parser, identifier);
 }
@@ -170,7 +170,7 @@ main (int argc, char *argv[])
 	if (shader == NULL)
 	   return 1;
 
-	ret = glcpp_preprocess(ctx, &shader, &info_log, NULL, NULL, &gl_ctx);
+	ret = glcpp_preprocess(ctx, &shader, &info_log, NULL, NULL, &gl_ctx, NULL);
 
 	fprintf(stderr, "%s", info_log);
 	fflush(stderr);
@@ -29,6 +29,7 @@
 
 #include "main/menums.h"
 
+#include "util/bitset.h"
 #include "util/ralloc.h"
 
 #include "util/hash_table.h"
@@ -186,10 +187,23 @@ typedef void (*glcpp_extension_iterator)(
 		unsigned version,
 		bool es);
 
+struct glcpp_identifiers;
+
 struct glcpp_parser {
 	linear_ctx *linalloc;
 	yyscan_t scanner;
 	struct hash_table *defines;
+
+	/** Interned IDENTIFIER token strings, see glcpp_identifiers_intern(). */
+	struct glcpp_identifiers *identifiers;
+
+	/**
+	 * The first two characters of every name that was ever #defined in
+	 * this parser.  Identifiers that are not in this set cannot be macros
+	 * and skip the lookup in \c ::defines.
+	 */
+	BITSET_DECLARE(macro_prefixes, 128 * 128);
+
 	active_list_t *active;
 	int lexing_directive;
 	int lexing_version_directive;
@@ -247,7 +261,26 @@ glcpp_parser_resolve_implicit_version(glcpp_parser_t *parser);
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 		 glcpp_extension_iterator extensions, void *state,
-		 struct gl_context *g_ctx);
+		 struct gl_context *g_ctx,
+		 struct glcpp_identifiers *identifiers);
+
+/* Identifier interning
+ *
+ * The preprocessor and the GLSL lexer share one table per compile, so an
+ * identifier is copied once no matter how many times it appears, and the
+ * GLSL lexer gets the string hash it needs for symbol lookups for free.
+ */
+
+struct glcpp_identifiers *
+glcpp_identifiers_create(void *mem_ctx);
+
+/* Returns the entry for the \p length characters at \p name, adding a copy
+ * if there is none yet.  name[length] must be '\0'.  The entry's key is the
+ * interned string and its hash is _mesa_hash_string() of it.
+ */
+struct hash_entry *
+glcpp_identifiers_intern(struct glcpp_identifiers *identifiers,
+			 const char *name, unsigned length);
 
 /* Functions for writing to the info log */
 
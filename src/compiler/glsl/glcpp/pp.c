@@ -221,15 +221,62 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return sb->buf;
 }
 
+struct glcpp_identifiers {
+	struct hash_table table;
+	linear_ctx *linalloc;
+};
+
+struct glcpp_identifiers *
+glcpp_identifiers_create(void *mem_ctx)
+{
+	struct glcpp_identifiers *identifiers =
+		ralloc(mem_ctx, struct glcpp_identifiers);
+
+	_mesa_hash_table_init(&identifiers->table, identifiers,
+			      _mesa_hash_string, _mesa_key_string_equal);
+	identifiers->linalloc = linear_context(identifiers);
+
+	return identifiers;
+}
+
+struct hash_entry *
+glcpp_identifiers_intern(struct glcpp_identifiers *identifiers,
+			 const char *name, unsigned length)
+{
+	uint32_t hash = _mesa_hash_string_with_length(name, length);
+	struct hash_entry *entry =
+		_mesa_hash_table_search_pre_hashed(&identifiers->table,
+						   hash, name);
+	char *copy;
+
+	assert(name[length] == '\0');
+
+	if (entry)
+		return entry;
+
+	/* We're not doing linear_strdup here, to avoid an implicit call
+	 * on strlen() for a length the lexers already know.
+	 */
+	copy = linear_alloc_child(identifiers->linalloc, length + 1);
+	memcpy(copy, name, length + 1);
+
+	return _mesa_hash_table_insert_pre_hashed(&identifiers->table,
+						  hash, copy, NULL);
+}
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
                  glcpp_extension_iterator extensions, void *state,
-                 struct gl_context *gl_ctx)
+                 struct gl_context *gl_ctx,
+                 struct glcpp_identifiers *identifiers)
 {
 	int errors;
 	glcpp_parser_t *parser =
 		glcpp_parser_create(gl_ctx, extensions, state);
 
+	if (identifiers)
+		parser->identifiers = identifiers;
+
 	if (! gl_ctx->Const.DisableGLSLLineContinuations)
 		*shader = remove_line_continuations(parser, *shader);
 
@@ -23,6 +23,7 @@
  */
 #include <ctype.h>
 #include <limits.h>
+#include "util/hash_table.h"
 #include "util/strtod.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
@@ -372,14 +373,10 @@ PATH		["][./ _A-Za-z0-9]*["]
 <PP>[ \t\r]*			{ }
 <PP>:				return COLON;
 <PP>[_a-zA-Z][_a-zA-Z0-9]*	{
-				   /* We're not doing linear_strdup here, to avoid an implicit call
-				    * on strlen() for the length of the string, as this is already
-				    * found by flex and stored in yyleng
-				    */
-                                    linear_ctx *mem_ctx = yyextra->linalloc;
-                                    char *id = (char *) linear_alloc_child(mem_ctx, yyleng + 1);
-                                    memcpy(id, yytext, yyleng + 1);
-                                    yylval->identifier = id;
+                                    struct hash_entry *entry =
+                                       glcpp_identifiers_intern(yyextra->identifiers,
+                                                                yytext, yyleng);
+                                    yylval->identifier = (const char *) entry->key;
 				   return IDENTIFIER;
 				}
 <PP>[1-9][0-9]*			{
@@ -808,21 +805,24 @@ int
 classify_identifier(struct _mesa_glsl_parse_state *state, const char *name,
                     unsigned name_len, YYSTYPE *output)
 {
-   /* We're not doing linear_strdup here, to avoid an implicit call on
-    * strlen() for the length of the string, as this is already found by flex
-    * and stored in yyleng
+   /* Identifiers were mostly interned by the preprocessor already, so this
+    * rarely allocates, and its hash is reused for the symbol lookup below.
     */
-   char *id = (char *) linear_alloc_child(state->linalloc, name_len + 1);
-   memcpy(id, name, name_len + 1);
-   output->identifier = id;
+   struct hash_entry *entry =
+      glcpp_identifiers_intern(state->identifiers, name, name_len);
+   output->identifier = (const char *) entry->key;
 
    if (state->is_field) {
       state->is_field = false;
       return FIELD_SELECTION;
    }
-   if (state->symbols->get_variable(name) || state->symbols->get_function(name))
+
+   bool is_variable_or_function, is_type;
+   state->symbols->classify(entry->hash, output->identifier,
+                            &is_variable_or_function, &is_type);
+   if (is_variable_or_function)
       return IDENTIFIER;
-   else if (state->symbols->get_type(name))
+   else if (is_type)
       return TYPE_IDENTIFIER;
    else
       return NEW_IDENTIFIER;
@@ -41,6 +41,7 @@
 #include "glsl_to_nir.h"
 #include "ir_optimization.h"
 #include "builtin_functions.h"
+#include "shader_cache.h"
 #include "pipe/p_screen.h"
 
 /**
@@ -73,6 +74,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->scanner = NULL;
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
+   this->identifiers = glcpp_identifiers_create(this);
 
    this->linalloc = linear_context(this);
 
@@ -2382,63 +2384,24 @@ log_compile_skip(struct gl_context *ctx, struct gl_shader *shader)
    }
 }
 
-void
-_mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
-                          FILE *dump_ir_file, bool dump_ast, bool dump_hir,
-                          bool force_recompile)
+static bool
+use_shader_stage_cache(struct gl_context *ctx, FILE *dump_ir_file,
+                       bool dump_ast, bool dump_hir)
 {
-   const char *source;
-   const uint8_t *source_blake3;
-
-   if (force_recompile && shader->FallbackSource) {
-      source = shader->FallbackSource;
-      source_blake3 = shader->fallback_source_blake3;
-   } else {
-      source = shader->Source;
-      source_blake3 = shader->source_blake3;
-   }
-
-   /* Note this will be true for shaders the have #include inside comments
-    * however that should be rare enough not to worry about.
-    */
-   bool source_has_shader_include =
-      strstr(source, "#include") == NULL ? false : true;
-
-   /* If there was no shader include we can check the shader cache and skip
-    * compilation before we run the preprocessor. We never skip compiling
-    * shaders that use ARB_shading_language_include because we would need to
-    * keep duplicate copies of the shader include source tree and paths.
-    */
-   if (!source_has_shader_include &&
-       can_skip_compile(ctx, shader, source, source_blake3, force_recompile,
-                        false)) {
-      log_compile_skip(ctx, shader);
-      return;
-   }
-
-    struct _mesa_glsl_parse_state *state =
-      new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
-
-   if (ctx->Const.GenerateTemporaryNames)
-      (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
-                              false, true);
-
-   if (!source_has_shader_include || !force_recompile) {
-      state->error = glcpp_preprocess(state, &source, &state->info_log,
-                                      add_builtin_defines, state, ctx);
-   }
+   /* Nothing to print when the front end is skipped. */
+   if (dump_ir_file || dump_ast || dump_hir)
+      return false;
 
-   /* Now that we have run the preprocessor we can check the shader cache and
-    * skip compilation if possible for those shaders that contained a shader
-    * include.
-    */
-   if (source_has_shader_include &&
-       can_skip_compile(ctx, shader, source, source_blake3, force_recompile,
-                        true)) {
-      log_compile_skip(ctx, shader);
-      return;
-   }
+   return ctx->Shared && ctx->_Shader &&
+          !(ctx->_Shader->Flags & (GLSL_DUMP | GLSL_CACHE_FALLBACK |
+                                   GLSL_NO_STAGE_CACHE));
+}
 
+static void
+compile_to_glsl_ir(struct gl_context *ctx, struct gl_shader *shader,
+                   struct _mesa_glsl_parse_state *state, const char *source,
+                   bool dump_ast, bool dump_hir)
+{
    if (!state->error) {
      _mesa_glsl_lexer_ctor(state, source);
      _mesa_glsl_parse(state);
@@ -2496,6 +2459,82 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       opt_shader(ctx->screen, &ctx->Const, &ctx->Extensions, shader,
                  state->linalloc);
    }
+}
+
+void
+_mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
+                          FILE *dump_ir_file, bool dump_ast, bool dump_hir,
+                          bool force_recompile)
+{
+   const char *source;
+   const uint8_t *source_blake3;
+
+   if (force_recompile && shader->FallbackSource) {
+      source = shader->FallbackSource;
+      source_blake3 = shader->fallback_source_blake3;
+   } else {
+      source = shader->Source;
+      source_blake3 = shader->source_blake3;
+   }
+
+   /* Note this will be true for shaders the have #include inside comments
+    * however that should be rare enough not to worry about.
+    */
+   bool source_has_shader_include =
+      strstr(source, "#include") == NULL ? false : true;
+
+   /* If there was no shader include we can check the shader cache and skip
+    * compilation before we run the preprocessor. We never skip compiling
+    * shaders that use ARB_shading_language_include because we would need to
+    * keep duplicate copies of the shader include source tree and paths.
+    */
+   if (!source_has_shader_include &&
+       can_skip_compile(ctx, shader, source, source_blake3, force_recompile,
+                        false)) {
+      log_compile_skip(ctx, shader);
+      return;
+   }
+
+    struct _mesa_glsl_parse_state *state =
+      new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
+
+   if (ctx->Const.GenerateTemporaryNames)
+      (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
+                              false, true);
+
+   if (!source_has_shader_include || !force_recompile) {
+      state->error = glcpp_preprocess(state, &source, &state->info_log,
+                                      add_builtin_defines, state, ctx,
+                                      state->identifiers);
+   }
+
+   /* Now that we have run the preprocessor we can check the shader cache and
+    * skip compilation if possible for those shaders that contained a shader
+    * include.
+    */
+   if (source_has_shader_include &&
+       can_skip_compile(ctx, shader, source, source_blake3, force_recompile,
+                        true)) {
+      log_compile_skip(ctx, shader);
+      return;
+   }
+
+   /* A stage with the same preprocessed source and compile state was
+    * compiled before, reuse its NIR and skip the rest of the front end.
+    */
+   blake3_hash stage_key;
+   const bool use_stage_cache = !state->error &&
+      use_shader_stage_cache(ctx, dump_ir_file, dump_ast, dump_hir);
+   bool stage_cached = false;
+
+   if (use_stage_cache) {
+      shader_cache_compute_stage_key(ctx, shader, source, stage_key);
+      stage_cached = shader_cache_read_stage(ctx, shader, stage_key,
+                                             source_blake3);
+   }
+
+   if (!stage_cached)
+      compile_to_glsl_ir(ctx, shader, state, source, dump_ast, dump_hir);
 
    if (!force_recompile) {
       free((void *)shader->FallbackSource);
@@ -2536,8 +2575,14 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    if (shader->CompileStatus == COMPILE_SUCCESS) {
       memcpy(shader->compiled_source_blake3, source_blake3, BLAKE3_OUT_LEN);
 
-      shader->nir = glsl_to_nir(shader, ctx->screen->nir_options[shader->Stage],
-                                source_blake3);
+      if (!stage_cached) {
+         shader->nir = glsl_to_nir(shader,
+                                   ctx->screen->nir_options[shader->Stage],
+                                   source_blake3);
+
+         if (use_stage_cache)
+            shader_cache_write_stage(ctx, shader, stage_key);
+      }
    }
 
    delete state->symbols;
@@ -389,6 +389,12 @@ struct _mesa_glsl_parse_state {
    ir_exec_list translation_unit;
    glsl_symbol_table *symbols;
 
+   /**
+    * Identifier strings interned by the preprocessor and the lexer, so
+    * repeated identifiers share one copy and carry their hash.
+    */
+   struct glcpp_identifiers *identifiers;
+
    linear_ctx *linalloc;
 
    unsigned num_supported_versions;
@@ -1125,6 +1131,7 @@ extern "C" {
 #endif
 
 struct glcpp_parser;
+struct glcpp_identifiers;
 struct _mesa_glsl_parse_state;
 
 struct gl_context;
@@ -1145,7 +1152,14 @@ typedef void (*glcpp_extension_iterator)(
 extern int glcpp_preprocess(void *ctx, const char **shader, char **info_log,
                             glcpp_extension_iterator extensions,
                             struct _mesa_glsl_parse_state *state,
-                            struct gl_context *gl_ctx);
+                            struct gl_context *gl_ctx,
+                            struct glcpp_identifiers *identifiers);
+
+extern struct glcpp_identifiers *glcpp_identifiers_create(void *mem_ctx);
+
+extern struct hash_entry *
+glcpp_identifiers_intern(struct glcpp_identifiers *identifiers,
+                         const char *name, unsigned length);
 
 #ifdef __cplusplus
 }
@@ -225,6 +225,16 @@ ir_function *glsl_symbol_table::get_function(const char *name)
    return entry != NULL ? entry->f : NULL;
 }
 
+void glsl_symbol_table::classify(uint32_t hash, const char *name,
+                                 bool *is_variable_or_function, bool *is_type)
+{
+   symbol_table_entry *entry = (symbol_table_entry *)
+      _mesa_symbol_table_find_symbol_pre_hashed(table, hash, name);
+
+   *is_variable_or_function = entry != NULL && (entry->v || entry->f);
+   *is_type = entry != NULL && entry->t;
+}
+
 int glsl_symbol_table::get_default_precision_qualifier(const char *type_name)
 {
    char *name = ralloc_asprintf(mem_ctx, "#default_precision_%s", type_name);
@@ -83,6 +83,14 @@ struct glsl_symbol_table {
    const glsl_type *get_type(const char *name);
    ir_function *get_function(const char *name);
    int get_default_precision_qualifier(const char *type_name);
+
+   /**
+    * Single lookup equivalent of get_variable() || get_function() and of
+    * get_type() for a name whose _mesa_hash_string() is \c hash.  Used by
+    * the lexer to classify identifiers.
+    */
+   void classify(uint32_t hash, const char *name,
+                 bool *is_variable_or_function, bool *is_type);
    /*@}*/
 
    /**
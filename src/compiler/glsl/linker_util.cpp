@@ -27,9 +27,11 @@
 #include "linker_util.h"
 #include "util/bitscan.h"
 #include "util/set.h"
+#include "util/u_queue.h"
 #include "util/u_range_remap.h"
 #include "main/consts_exts.h"
 #include "main/context.h"
+#include "main/shared.h"
 
 void
 linker_error(gl_shader_program *prog, const char *fmt, ...)
@@ -506,3 +508,72 @@ resource_name_updated(struct gl_resource_name *name)
       name->suffix_is_zero_square_bracketed = false;
    }
 }
+
+struct link_util_stage_job {
+   struct gl_linked_shader *shader;
+   link_util_stage_func func;
+   void *data;
+   struct util_queue_fence fence;
+};
+
+static void
+link_util_stage_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct link_util_stage_job *job = (struct link_util_stage_job *)data;
+
+   job->func(job->shader, job->data);
+}
+
+/**
+ * Returns the queue for per-stage link work, or NULL if the stages must be
+ * processed one after the other on the calling thread.  GLSL_DUMP output
+ * would be interleaved, so it disables the queue too.
+ */
+struct util_queue *
+link_util_get_stage_queue(struct gl_context *ctx)
+{
+   if (!ctx->Shared ||
+       (ctx->_Shader &&
+        ctx->_Shader->Flags & (GLSL_DUMP | GLSL_SERIAL_LINK)))
+      return NULL;
+
+   return _mesa_get_shared_worker_queue(ctx);
+}
+
+/**
+ * Calls func for each shader and returns once all calls are done.  With a
+ * queue, the first shader is processed on the calling thread and the other
+ * ones on the queue.
+ */
+void
+link_util_run_per_stage(struct util_queue *queue,
+                        struct gl_linked_shader **shaders,
+                        unsigned num_shaders,
+                        link_util_stage_func func, void *data)
+{
+   struct link_util_stage_job jobs[MESA_SHADER_MESH_STAGES];
+
+   assert(num_shaders <= MESA_SHADER_MESH_STAGES);
+
+   if (!queue || num_shaders <= 1) {
+      for (unsigned i = 0; i < num_shaders; i++)
+         func(shaders[i], data);
+      return;
+   }
+
+   for (unsigned i = 1; i < num_shaders; i++) {
+      jobs[i].shader = shaders[i];
+      jobs[i].func = func;
+      jobs[i].data = data;
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(queue, &jobs[i], &jobs[i].fence,
+                         link_util_stage_job_execute, NULL, 0);
+   }
+
+   func(shaders[0], data);
+
+   for (unsigned i = 1; i < num_shaders; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
@@ -33,6 +33,7 @@
 
 struct gl_constants;
 struct gl_shader_program;
+struct util_queue;
 struct gl_uniform_storage;
 struct set;
 
@@ -132,6 +133,23 @@ link_util_calculate_subroutine_compat(struct gl_shader_program *prog);
 void
 resource_name_updated(struct gl_resource_name *name);
 
+/**
+ * Per-stage link work.  It may run on a worker thread, concurrently with
+ * the other stages of the program, so it must only modify the stage's own
+ * gl_program and NIR.  In particular it must not report linker errors.
+ */
+typedef void (*link_util_stage_func)(struct gl_linked_shader *shader,
+                                     void *data);
+
+struct util_queue *
+link_util_get_stage_queue(struct gl_context *ctx);
+
+void
+link_util_run_per_stage(struct util_queue *queue,
+                        struct gl_linked_shader **shaders,
+                        unsigned num_shaders,
+                        link_util_stage_func func, void *data);
+
 /**
  * Get the string value for an interpolation qualifier
  *
@@ -47,6 +47,7 @@ const struct option compiler_opts[] = {
    { "just-log", no_argument, &options.just_log, 1 },
    { "lower-precision", no_argument, &options.lower_precision, 1 },
    { "version",  required_argument, NULL, 'v' },
+   { "benchmark", required_argument, NULL, 'b' },
    { NULL, 0, NULL, 0 }
 };
 
@@ -83,6 +84,9 @@ main(int argc, char * const* argv)
       case 'v':
          options.glsl_version = strtol(optarg, NULL, 10);
          break;
+      case 'b':
+         options.benchmark = strtol(optarg, NULL, 10);
+         break;
       default:
          break;
       }
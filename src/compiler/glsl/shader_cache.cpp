@@ -53,11 +53,13 @@
 #include "ir_optimization.h"
 #include "ir_rvalue_visitor.h"
 #include "nir.h"
+#include "nir_serialize.h"
 #include "serialize.h"
 #include "shader_cache.h"
 #include "util/mesa-blake3.h"
 #include "string_to_uint_map.h"
 #include "main/mtypes.h"
+#include "pipe/p_screen.h"
 
 extern "C" {
 #include "main/enums.h"
@@ -261,3 +263,269 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
 
    return true;
 }
+
+/* Serialized stages kept in memory per share group.  Once full, new stages
+ * only go to the disk cache.
+ */
+#define SHADER_STAGE_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+struct stage_cache_entry {
+   blake3_hash key;
+   size_t size;
+   uint8_t *data;
+};
+
+/* The gl_shader flags set by compiling a stage. */
+static bool gl_shader::*const stage_bool_fields[] = {
+   &gl_shader::IsES,
+   &gl_shader::has_implicit_conversions,
+   &gl_shader::has_implicit_int_to_uint_conversion,
+   &gl_shader::EarlyFragmentTests,
+   &gl_shader::ARB_fragment_coord_conventions_enable,
+   &gl_shader::KHR_shader_subgroup_basic_enable,
+   &gl_shader::redeclares_gl_fragcoord,
+   &gl_shader::uses_gl_fragcoord,
+   &gl_shader::PostDepthCoverage,
+   &gl_shader::PixelInterlockOrdered,
+   &gl_shader::PixelInterlockUnordered,
+   &gl_shader::SampleInterlockOrdered,
+   &gl_shader::SampleInterlockUnordered,
+   &gl_shader::InnerCoverage,
+   &gl_shader::origin_upper_left,
+   &gl_shader::pixel_center_integer,
+   &gl_shader::bindless_sampler,
+   &gl_shader::bindless_image,
+   &gl_shader::bound_sampler,
+   &gl_shader::bound_image,
+   &gl_shader::redeclares_gl_layer,
+   &gl_shader::layer_viewport_relative,
+};
+
+static uint32_t
+stage_key_hash(const void *key)
+{
+   uint32_t hash;
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+stage_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(blake3_hash)) == 0;
+}
+
+void
+shader_cache_compute_stage_key(struct gl_context *ctx,
+                               const struct gl_shader *shader,
+                               const char *preprocessed_source,
+                               blake3_hash key)
+{
+   struct mesa_blake3 blake3;
+   _mesa_blake3_init(&blake3);
+
+   /* Same compile state as shader_cache_read_program_metadata() hashes,
+    * plus the enabled extensions, which decide the built-ins a stage sees.
+    */
+   char *buf = ralloc_asprintf(NULL, "stage: %d api: %d glsl: %d fglsl: %d\n",
+                               shader->Stage, ctx->API,
+                               ctx->Const.GLSLVersion,
+                               ctx->Const.ForceGLSLVersion);
+   const char *ext_override = os_get_option("MESA_EXTENSION_OVERRIDE");
+   if (ext_override)
+      ralloc_asprintf_append(&buf, "ext:%s", ext_override);
+
+   _mesa_blake3_update(&blake3, buf, strlen(buf));
+   _mesa_blake3_update(&blake3, ctx->Const.dri_config_options_blake3,
+                       sizeof(ctx->Const.dri_config_options_blake3));
+   _mesa_blake3_update(&blake3, &ctx->Extensions, sizeof(ctx->Extensions));
+   _mesa_blake3_update(&blake3, preprocessed_source,
+                       strlen(preprocessed_source));
+   _mesa_blake3_final(&blake3, key);
+
+   ralloc_free(buf);
+}
+
+static void
+serialize_stage(struct blob *blob, struct gl_shader *shader)
+{
+   blob_write_string(blob, shader->InfoLog ? shader->InfoLog : "");
+   blob_write_uint32(blob, shader->Version);
+   blob_write_uint32(blob, shader->BlendSupport);
+   blob_write_uint32(blob, shader->view_mask);
+   blob_write_bytes(blob, shader->TransformFeedbackBufferStride,
+                    sizeof(shader->TransformFeedbackBufferStride));
+   blob_write_bytes(blob, &shader->info, sizeof(shader->info));
+
+   for (unsigned i = 0; i < ARRAY_SIZE(stage_bool_fields); i++)
+      blob_write_uint8(blob, shader->*stage_bool_fields[i]);
+
+   nir_serialize(blob, shader->nir, false);
+}
+
+static bool
+deserialize_stage(struct blob_reader *blob, struct gl_context *ctx,
+                  struct gl_shader *shader, const uint8_t *source_blake3)
+{
+   const char *info_log = blob_read_string(blob);
+   shader->Version = blob_read_uint32(blob);
+   shader->BlendSupport = blob_read_uint32(blob);
+   shader->view_mask = blob_read_uint32(blob);
+   blob_copy_bytes(blob, shader->TransformFeedbackBufferStride,
+                   sizeof(shader->TransformFeedbackBufferStride));
+   blob_copy_bytes(blob, &shader->info, sizeof(shader->info));
+
+   for (unsigned i = 0; i < ARRAY_SIZE(stage_bool_fields); i++)
+      shader->*stage_bool_fields[i] = blob_read_uint8(blob) != 0;
+
+   if (blob->overrun)
+      return false;
+
+   nir_shader *nir =
+      nir_deserialize(NULL, ctx->screen->nir_options[shader->Stage], blob);
+   if (blob->overrun || blob->current != blob->end) {
+      ralloc_free(nir);
+      return false;
+   }
+
+   /* glsl_to_nir() names the wrapper of global instructions after the
+    * source, which may differ from the one the entry was created from.
+    */
+   char blake3_str[BLAKE3_HEX_LEN];
+   char name[45];
+   _mesa_blake3_format(blake3_str, source_blake3);
+   snprintf(name, sizeof(name), "%s_%s", "gl_mesa_tmp", blake3_str);
+   nir_foreach_function(func, nir) {
+      if (func->is_tmp_globals_wrapper)
+         func->name = ralloc_strdup(func, name);
+   }
+
+   ralloc_free(shader->ir);
+   ralloc_free(shader->nir);
+   ralloc_free(shader->InfoLog);
+   shader->ir = NULL;
+   shader->nir = nir;
+   shader->InfoLog = ralloc_strdup(shader, info_log);
+   shader->CompileStatus = COMPILE_SUCCESS;
+
+   return true;
+}
+
+/* Adds a copy of the serialized stage to the in-memory cache, unless it is
+ * full.  Entries are never removed before the share group is destroyed.
+ */
+static void
+stage_cache_insert(struct gl_shared_state *shared, const blake3_hash key,
+                   const void *data, size_t size)
+{
+   simple_mtx_lock(&shared->Mutex);
+
+   if (!shared->ShaderStageCache) {
+      shared->ShaderStageCache =
+         _mesa_hash_table_create(NULL, stage_key_hash, stage_key_equal);
+   }
+
+   if (shared->ShaderStageCacheSize + size <= SHADER_STAGE_CACHE_MAX_SIZE &&
+       !_mesa_hash_table_search(shared->ShaderStageCache, key)) {
+      struct stage_cache_entry *entry = (struct stage_cache_entry *)
+         malloc(sizeof(*entry) + size);
+
+      if (entry) {
+         memcpy(entry->key, key, sizeof(entry->key));
+         entry->size = size;
+         entry->data = (uint8_t *)(entry + 1);
+         memcpy(entry->data, data, size);
+
+         _mesa_hash_table_insert(shared->ShaderStageCache, entry->key, entry);
+         shared->ShaderStageCacheSize += size;
+      }
+   }
+
+   simple_mtx_unlock(&shared->Mutex);
+}
+
+bool
+shader_cache_read_stage(struct gl_context *ctx, struct gl_shader *shader,
+                        const blake3_hash key, const uint8_t *source_blake3)
+{
+   struct gl_shared_state *shared = ctx->Shared;
+   struct stage_cache_entry *entry = NULL;
+   const void *data = NULL;
+   void *disk_data = NULL;
+   size_t size = 0;
+   cache_key disk_key;
+
+   simple_mtx_lock(&shared->Mutex);
+   if (shared->ShaderStageCache) {
+      struct hash_entry *he =
+         _mesa_hash_table_search(shared->ShaderStageCache, key);
+      entry = he ? (struct stage_cache_entry *) he->data : NULL;
+   }
+   simple_mtx_unlock(&shared->Mutex);
+
+   if (entry) {
+      data = entry->data;
+      size = entry->size;
+   } else if (ctx->Cache) {
+      disk_cache_compute_key(ctx->Cache, key, sizeof(blake3_hash), disk_key);
+      disk_data = disk_cache_get(ctx->Cache, disk_key, &size);
+      data = disk_data;
+   }
+
+   if (!data)
+      return false;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, data, size);
+   bool deserialized = deserialize_stage(&blob, ctx, shader, source_blake3);
+
+   if (!deserialized) {
+      /* Something has gone wrong, drop the item from the disk cache and
+       * compile from source.
+       */
+      assert(!"Invalid GLSL shader stage cache item!");
+      if (disk_data)
+         disk_cache_remove(ctx->Cache, disk_key);
+   } else if (disk_data) {
+      stage_cache_insert(shared, key, disk_data, size);
+   }
+
+   if (deserialized && (ctx->_Shader->Flags & GLSL_CACHE_INFO)) {
+      char blake3_buf[BLAKE3_HEX_LEN];
+      _mesa_blake3_format(blake3_buf, key);
+      fprintf(stderr, "loading shader stage from %s cache: %s\n",
+              entry ? "memory" : "disk", blake3_buf);
+   }
+
+   free(disk_data);
+   return deserialized;
+}
+
+void
+shader_cache_write_stage(struct gl_context *ctx, struct gl_shader *shader,
+                         const blake3_hash key)
+{
+   struct blob blob;
+   blob_init(&blob);
+
+   serialize_stage(&blob, shader);
+
+   if (!blob.out_of_memory) {
+      stage_cache_insert(ctx->Shared, key, blob.data, blob.size);
+
+      if (ctx->Cache) {
+         cache_key disk_key;
+         disk_cache_compute_key(ctx->Cache, key, sizeof(blake3_hash),
+                                disk_key);
+         disk_cache_put(ctx->Cache, disk_key, blob.data, blob.size, NULL);
+      }
+
+      if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+         char blake3_buf[BLAKE3_HEX_LEN];
+         _mesa_blake3_format(blake3_buf, key);
+         fprintf(stderr, "putting shader stage in cache: %s\n", blake3_buf);
+      }
+   }
+
+   blob_finish(&blob);
+}
@@ -27,6 +27,7 @@
 #include "util/disk_cache.h"
 
 struct gl_context;
+struct gl_shader;
 struct gl_shader_program;
 
 void
@@ -37,4 +38,23 @@ bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog);
 
+/* Cache of single compiled shader stages, that is the pre-link NIR and the
+ * gl_shader state produced by _mesa_glsl_compile_shader(), so a stage seen
+ * before skips the GLSL front end no matter which program it ends up in.
+ * Entries live in memory for the share group and in the disk cache.
+ */
+void
+shader_cache_compute_stage_key(struct gl_context *ctx,
+                               const struct gl_shader *shader,
+                               const char *preprocessed_source,
+                               blake3_hash key);
+
+bool
+shader_cache_read_stage(struct gl_context *ctx, struct gl_shader *shader,
+                        const blake3_hash key, const uint8_t *source_blake3);
+
+void
+shader_cache_write_stage(struct gl_context *ctx, struct gl_shader *shader,
+                         const blake3_hash key);
+
 #endif /* SHADER_CACHE_H */
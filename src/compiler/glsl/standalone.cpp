@@ -34,6 +34,7 @@
 #include "ir_optimization.h"
 #include "standalone_scaffolding.h"
 #include "standalone.h"
+#include "util/os_time.h"
 #include "util/set.h"
 #include "gl_nir_linker.h"
 #include "glsl_parser_extras.h"
@@ -321,6 +322,37 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
                              options->dump_hir, true);
 }
 
+/**
+ * Compiles \c shader another options->benchmark times and prints the
+ * throughput of the compiler front end.  Returns the time spent, in
+ * nanoseconds.
+ */
+static int64_t
+benchmark_shader(struct gl_context *ctx, const struct gl_shader *shader,
+                 const char *file)
+{
+   const size_t size = strlen(shader->Source);
+   const int64_t start = os_time_get_nano();
+
+   for (int i = 0; i < options->benchmark; i++) {
+      struct gl_shader *copy = rzalloc(NULL, struct gl_shader);
+      copy->Type = shader->Type;
+      copy->Stage = shader->Stage;
+      copy->Source = shader->Source;
+      memcpy(copy->source_blake3, shader->source_blake3, BLAKE3_OUT_LEN);
+
+      compile_shader(ctx, copy);
+      ralloc_free(copy);
+   }
+
+   const int64_t elapsed = MAX2(os_time_get_nano() - start, 1);
+   printf("%s: %.1f compiles/s, %.2f MB/s\n", file,
+          options->benchmark * 1e9 / elapsed,
+          (double)size * options->benchmark * 1e3 / elapsed);
+
+   return elapsed;
+}
+
 extern "C" struct gl_shader_program *
 standalone_compile_shader(const struct standalone_options *_options,
       unsigned num_files, char* const* files, struct gl_context *ctx)
@@ -375,6 +407,8 @@ standalone_compile_shader(const struct standalone_options *_options,
    }
 
    struct gl_shader_program *whole_program = standalone_create_shader_program();
+   int64_t benchmark_time = 0;
+   size_t benchmark_size = 0;
 
    for (unsigned i = 0; i < num_files; i++) {
       const unsigned len = strlen(files[i]);
@@ -422,6 +456,18 @@ standalone_compile_shader(const struct standalone_options *_options,
          status = EXIT_FAILURE;
          break;
       }
+
+      if (options->benchmark > 0) {
+         benchmark_time += benchmark_shader(ctx, shader, files[i]);
+         benchmark_size += strlen(source);
+      }
+   }
+
+   if (status == EXIT_SUCCESS && options->benchmark > 0 && num_files > 1) {
+      printf("total: %.1f compiles/s, %.2f MB/s\n",
+             (double)num_files * options->benchmark * 1e9 / benchmark_time,
+             (double)benchmark_size * options->benchmark * 1e3 /
+             benchmark_time);
    }
 
    if (status == EXIT_SUCCESS && options->do_link) {
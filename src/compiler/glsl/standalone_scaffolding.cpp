@@ -148,6 +148,12 @@ _mesa_delete_linked_shader(struct gl_context *,
    ralloc_free(sh);
 }
 
+struct util_queue *
+_mesa_get_shared_worker_queue(struct gl_context *)
+{
+   return NULL;
+}
+
 void
 _mesa_clear_shader_program_data(struct gl_context *ctx,
                                 struct gl_shader_program *shProg)
@@ -70,6 +70,9 @@ extern "C" void
 _mesa_shader_debug(struct gl_context *ctx, GLenum type, GLuint *id,
                    const char *msg);
 
+extern "C" struct util_queue *
+_mesa_get_shared_worker_queue(struct gl_context *ctx);
+
 extern "C" GLbitfield
 _mesa_program_state_flags(const gl_state_index16 state[STATE_LENGTH]);
 
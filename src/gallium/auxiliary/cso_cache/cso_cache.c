@@ -35,6 +35,9 @@
 #include "cso_cache.h"
 #include "cso_hash.h"
 
+#define XXH_INLINE_ALL
+#include "util/xxhash.h"
+
 
 /* Default delete callback. It can also be used by custom callbacks. */
 void
@@ -66,49 +69,198 @@ cso_delete_state(struct pipe_context *pipe, void *state,
 }
 
 
+/* Smallest table allocated on first insertion. */
+#define CSO_CACHE_MIN_TABLE_SIZE 64
+
+
+uint64_t
+cso_construct_key(const void *key, int key_size)
+{
+   assert(key_size % 4 == 0);
+   return XXH3_64bits(key, key_size);
+}
+
+
+static inline bool
+entry_is_live(const struct cso_cache_entry *entry)
+{
+   return entry->state && entry->state != CSO_CACHE_TOMBSTONE;
+}
+
+
+static bool
+table_resize(struct cso_cache_table *table, unsigned new_size)
+{
+   struct cso_cache_entry *entries = CALLOC(new_size, sizeof(*entries));
+   if (!entries)
+      return false;
+
+   /* The stored hashes are reused, states are never rehashed. */
+   const unsigned mask = new_size - 1;
+   for (unsigned i = 0; i < table->size; i++) {
+      const struct cso_cache_entry *entry = &table->entries[i];
+
+      if (!entry_is_live(entry))
+         continue;
+
+      unsigned j = entry->hash & mask;
+      while (entries[j].state)
+         j = (j + 1) & mask;
+      entries[j] = *entry;
+   }
+
+   FREE(table->entries);
+   table->entries = entries;
+   table->size = new_size;
+   table->tombstones = 0;
+   return true;
+}
+
+
 static inline void
 sanitize_hash(struct cso_cache *sc,
-              struct cso_hash *hash,
               enum cso_cache_type type,
               int max_size)
 {
    if (sc->sanitize_cb)
-      sc->sanitize_cb(hash, type, max_size, sc->sanitize_data);
+      sc->sanitize_cb(sc, type, max_size, sc->sanitize_data);
 }
 
 
-static inline void
-sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
-            int max_size, void *user_data)
+static bool
+evict_cb(void *user_data, void *state, enum cso_cache_type type)
 {
    struct cso_cache *cache = (struct cso_cache *)user_data;
 
-   /* if we're approach the maximum size, remove fourth of the entries
-    * otherwise every subsequent call will go through the same */
-   int hash_size = cso_hash_size(hash);
-   int max_entries = (max_size > hash_size) ? max_size : hash_size;
-   int to_remove =  (max_size < max_entries) * max_entries/4;
-   if (hash_size > max_size)
-      to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      struct cso_hash_iter iter = cso_hash_first_node(hash);
-      void  *cso = cso_hash_take(hash, cso_hash_iter_key(iter));
-      cache->delete_cso(cache->delete_cso_ctx, cso, type);
-      --to_remove;
+   cache->delete_cso(cache->delete_cso_ctx, state, type);
+   return true;
+}
+
+
+static void
+sanitize_cb(struct cso_cache *sc, enum cso_cache_type type,
+            int max_size, void *user_data)
+{
+   unsigned to_remove = cso_cache_num_to_evict(sc, type, max_size);
+
+   if (to_remove)
+      cso_cache_evict_lru(sc, type, to_remove, evict_cb, sc);
+}
+
+
+/* If we're approaching the maximum size, remove a fourth of the entries,
+ * otherwise every subsequent insertion would go through the same.
+ */
+unsigned
+cso_cache_num_to_evict(const struct cso_cache *sc, enum cso_cache_type type,
+                       int max_size)
+{
+   const int size = sc->tables[type].count;
+   const int max_entries = MAX2(max_size, size);
+   int to_remove = (max_size < max_entries) * max_entries / 4;
+
+   if (size > max_size)
+      to_remove += size - max_size;
+
+   return to_remove;
+}
+
+
+struct lru_slot {
+   uint64_t last_used;
+   unsigned index;
+};
+
+
+static int
+lru_slot_compare(const void *a, const void *b)
+{
+   const struct lru_slot *sa = a, *sb = b;
+
+   return sa->last_used < sb->last_used ? -1 : sa->last_used > sb->last_used;
+}
+
+
+/* Evict up to to_remove states of the given type, least recently used
+ * first. States for which the callback returns false stay in the cache.
+ */
+void
+cso_cache_evict_lru(struct cso_cache *sc, enum cso_cache_type type,
+                    unsigned to_remove, cso_evict_callback evict,
+                    void *user_data)
+{
+   struct cso_cache_table *table = &sc->tables[type];
+
+   if (!to_remove || !table->count)
+      return;
+
+   struct lru_slot *slots = MALLOC(table->count * sizeof(*slots));
+   if (!slots)
+      return;
+
+   unsigned num_slots = 0;
+   for (unsigned i = 0; i < table->size; i++) {
+      if (entry_is_live(&table->entries[i])) {
+         slots[num_slots].last_used = table->entries[i].last_used;
+         slots[num_slots].index = i;
+         num_slots++;
+      }
+   }
+   assert(num_slots == table->count);
+
+   qsort(slots, num_slots, sizeof(*slots), lru_slot_compare);
+
+   for (unsigned i = 0; i < num_slots && to_remove; i++) {
+      struct cso_cache_entry *entry = &table->entries[slots[i].index];
+
+      if (evict(user_data, entry->state, type)) {
+         entry->state = CSO_CACHE_TOMBSTONE;
+         table->count--;
+         table->tombstones++;
+         to_remove--;
+      }
    }
+
+   FREE(slots);
 }
 
 
-struct cso_hash_iter
+bool
 cso_insert_state(struct cso_cache *sc,
-                 unsigned hash_key, enum cso_cache_type type,
+                 uint64_t hash_key, enum cso_cache_type type,
                  void *state)
 {
-   struct cso_hash *hash = &sc->hashes[type];
-   sanitize_hash(sc, hash, type, sc->max_size);
-   return cso_hash_insert(hash, hash_key, state);
+   struct cso_cache_table *table = &sc->tables[type];
+
+   sanitize_hash(sc, type, sc->max_size);
+
+   /* Rebuild the table once live states and tombstones fill half of it,
+    * growing it so that it is at most a third full afterwards.
+    */
+   if ((table->count + table->tombstones + 1) * 2 > table->size) {
+      unsigned new_size = MAX2(table->size, CSO_CACHE_MIN_TABLE_SIZE);
+
+      while ((table->count + 1) * 3 > new_size)
+         new_size *= 2;
+
+      if (!table_resize(table, new_size))
+         return false;
+   }
+
+   const unsigned mask = table->size - 1;
+   unsigned i = hash_key & mask;
+   while (entry_is_live(&table->entries[i]))
+      i = (i + 1) & mask;
+
+   struct cso_cache_entry *entry = &table->entries[i];
+   if (entry->state == CSO_CACHE_TOMBSTONE)
+      table->tombstones--;
+
+   entry->hash = hash_key;
+   entry->last_used = ++sc->lru_clock;
+   entry->state = state;
+   table->count++;
+   return true;
 }
 
 
@@ -137,8 +289,6 @@ cso_cache_init(struct cso_cache *sc, struct pipe_context *pipe)
    memset(sc, 0, sizeof(*sc));
 
    sc->max_size = 4096;
-   for (int i = 0; i < CSO_CACHE_MAX; i++)
-      cso_hash_init(&sc->hashes[i]);
 
    sc->sanitize_cb = sanitize_cb;
    sc->sanitize_data = sc;
@@ -150,15 +300,15 @@ cso_cache_init(struct cso_cache *sc, struct pipe_context *pipe)
 static void
 cso_delete_all(struct cso_cache *sc, enum cso_cache_type type)
 {
-   struct cso_hash *hash = &sc->hashes[type];
-   struct cso_hash_iter iter = cso_hash_first_node(hash);
-   while (!cso_hash_iter_is_null(iter)) {
-      void *state = cso_hash_iter_data(iter);
-      iter = cso_hash_iter_next(iter);
-      if (state) {
-         sc->delete_cso(sc->delete_cso_ctx, state, type);
-      }
+   struct cso_cache_table *table = &sc->tables[type];
+
+   for (unsigned i = 0; i < table->size; i++) {
+      if (entry_is_live(&table->entries[i]))
+         sc->delete_cso(sc->delete_cso_ctx, table->entries[i].state, type);
    }
+
+   FREE(table->entries);
+   memset(table, 0, sizeof(*table));
 }
 
 
@@ -171,9 +321,6 @@ cso_cache_delete(struct cso_cache *sc)
    cso_delete_all(sc, CSO_RASTERIZER);
    cso_delete_all(sc, CSO_SAMPLER);
    cso_delete_all(sc, CSO_VELEMENTS);
-
-   for (int i = 0; i < CSO_CACHE_MAX; i++)
-      cso_hash_deinit(&sc->hashes[i]);
 }
 
 
@@ -183,7 +330,7 @@ cso_set_maximum_cache_size(struct cso_cache *sc, int number)
    sc->max_size = number;
 
    for (int i = 0; i < CSO_CACHE_MAX; i++)
-      sanitize_hash(sc, &sc->hashes[i], i, sc->max_size);
+      sanitize_hash(sc, i, sc->max_size);
 }
 
 
@@ -76,10 +76,6 @@
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
 
-/* cso_hash.h is necessary for cso_hash_iter, as MSVC requires structures
- * returned by value to be fully defined */
-#include "cso_hash.h"
-
 
 #ifdef __cplusplus
 extern "C" {
@@ -99,13 +95,42 @@ typedef void (*cso_delete_cso_callback)(void *ctx, void *state,
 
 typedef void (*cso_state_callback)(void *ctx, void *obj);
 
-typedef void (*cso_sanitize_callback)(struct cso_hash *hash,
+struct cso_cache;
+
+typedef void (*cso_sanitize_callback)(struct cso_cache *sc,
                                       enum cso_cache_type type,
                                       int max_size,
                                       void *user_data);
 
+/* Returns true if the state was deleted and can be dropped from the cache,
+ * false if it is still in use and has to be kept. */
+typedef bool (*cso_evict_callback)(void *user_data, void *state,
+                                   enum cso_cache_type type);
+
+/* Marks a slot that held a state which has since been evicted. Probing
+ * continues past it, insertion may reuse it. */
+#define CSO_CACHE_TOMBSTONE ((void *)(uintptr_t)1)
+
+struct cso_cache_entry {
+   uint64_t hash;
+   uint64_t last_used;
+   void *state;         /* NULL if the slot is empty */
+};
+
+/* Open-addressing table with linear probing, one per state type. The load
+ * factor including tombstones is kept at or below 1/2, so probing always
+ * terminates on an empty slot.
+ */
+struct cso_cache_table {
+   struct cso_cache_entry *entries;
+   unsigned size;       /* power of two, or 0 before the first insertion */
+   unsigned count;      /* live states */
+   unsigned tombstones;
+};
+
 struct cso_cache {
-   struct cso_hash hashes[CSO_CACHE_MAX];
+   struct cso_cache_table tables[CSO_CACHE_MAX];
+   uint64_t lru_clock;
    int max_size;
 
    cso_sanitize_callback sanitize_cb;
@@ -133,7 +158,7 @@ struct cso_rasterizer {
 struct cso_sampler {
    struct pipe_sampler_state state;
    void *data;
-   unsigned hash_key;
+   bool pinned;         /* protected from eviction while set */
 };
 
 struct cso_velems_state {
@@ -162,9 +187,9 @@ cso_cache_set_delete_cso_callback(struct cso_cache *sc,
                                   cso_delete_cso_callback delete_cso,
                                   void *ctx);
 
-struct cso_hash_iter
+bool
 cso_insert_state(struct cso_cache *sc,
-                 unsigned hash_key, enum cso_cache_type type,
+                 uint64_t hash_key, enum cso_cache_type type,
                  void *state);
 
 void
@@ -174,37 +199,41 @@ void
 cso_delete_state(struct pipe_context *pipe, void *state,
                  enum cso_cache_type type);
 
+unsigned
+cso_cache_num_to_evict(const struct cso_cache *sc, enum cso_cache_type type,
+                       int max_size);
 
-static ALWAYS_INLINE unsigned
-cso_construct_key(const void *key, int key_size)
-{
-   unsigned hash = 0;
-   const unsigned *ikey = (const unsigned *)key;
-   unsigned num_elements = key_size / 4;
-
-   assert(key_size % 4 == 0);
-
-   for (unsigned i = 0; i < num_elements; i++)
-      hash ^= ikey[i];
+void
+cso_cache_evict_lru(struct cso_cache *sc, enum cso_cache_type type,
+                    unsigned to_remove, cso_evict_callback evict,
+                    void *user_data);
 
-   return hash;
-}
+uint64_t
+cso_construct_key(const void *key, int key_size);
 
-static ALWAYS_INLINE struct cso_hash_iter
-cso_find_state_template(struct cso_cache *sc, unsigned hash_key,
+static ALWAYS_INLINE void *
+cso_find_state_template(struct cso_cache *sc, uint64_t hash_key,
                         enum cso_cache_type type, const void *key,
                         unsigned key_size)
 {
-   struct cso_hash *hash = &sc->hashes[type];
-   struct cso_hash_iter iter = cso_hash_find(hash, hash_key);
-
-   while (!cso_hash_iter_is_null(iter)) {
-      void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, key, key_size))
-         return iter;
-      iter = cso_hash_iter_next(iter);
+   struct cso_cache_table *table = &sc->tables[type];
+
+   if (!table->count)
+      return NULL;
+
+   const unsigned mask = table->size - 1;
+   for (unsigned i = hash_key & mask;; i = (i + 1) & mask) {
+      struct cso_cache_entry *entry = &table->entries[i];
+
+      if (!entry->state)
+         return NULL;
+
+      if (entry->hash == hash_key && entry->state != CSO_CACHE_TOMBSTONE &&
+          !memcmp(entry->state, key, key_size)) {
+         entry->last_used = ++sc->lru_clock;
+         return entry->state;
+      }
    }
-   return iter;
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: MIT */
+
+/* Measures cso_cache lookups replaying the state sequence of a
+ * state-thrashing GL app. Not run as part of the test suite.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "cso_cache.h"
+#include "util/os_time.h"
+#include "util/u_memory.h"
+
+struct bench_state {
+   uint32_t key[16];
+};
+
+static void
+delete_bench_state(void *ctx, void *state, enum cso_cache_type type)
+{
+   FREE(state);
+}
+
+static bool
+find_or_insert(struct cso_cache *sc, uint32_t id)
+{
+   uint32_t key[16];
+
+   for (unsigned i = 0; i < 16; i++)
+      key[i] = id * 0x9e3779b9u + i;
+   key[0] = id;
+
+   const uint64_t hash_key = cso_construct_key(key, sizeof(key));
+   if (cso_find_state_template(sc, hash_key, CSO_RASTERIZER, key, sizeof(key)))
+      return false;
+
+   struct bench_state *state = CALLOC_STRUCT(bench_state);
+   memcpy(state->key, key, sizeof(key));
+   if (!cso_insert_state(sc, hash_key, CSO_RASTERIZER, state))
+      FREE(state);
+   return true;
+}
+
+static void
+replay(unsigned max_size)
+{
+   const unsigned num_lookups = 1 << 22;
+   std::vector<uint32_t> sequence(num_lookups);
+   uint32_t seed = 1;
+   uint32_t next_new = 1 << 16;
+
+   /* A small hot set rebound every draw, a larger warm set, and a trickle
+    * of new states.
+    */
+   for (unsigned i = 0; i < num_lookups; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      unsigned r = seed >> 8;
+
+      if (r % 100 < 80)
+         sequence[i] = r % 32;
+      else if (r % 100 < 99)
+         sequence[i] = 32 + r % 2048;
+      else
+         sequence[i] = next_new++;
+   }
+
+   struct cso_cache cache;
+   cso_cache_init(&cache, NULL);
+   cso_cache_set_delete_cso_callback(&cache, delete_bench_state, NULL);
+   cso_set_maximum_cache_size(&cache, max_size);
+
+   /* Warm up so that the timed pass measures lookups, not creation. */
+   for (uint32_t id : sequence)
+      find_or_insert(&cache, id);
+
+   unsigned misses = 0;
+   int64_t start = os_time_get_nano();
+   for (uint32_t id : sequence)
+      misses += find_or_insert(&cache, id);
+   int64_t elapsed = os_time_get_nano() - start;
+
+   printf("max size %5u: %u lookups, %u misses, %.1f ns/lookup\n",
+          max_size, num_lookups, misses, (double)elapsed / num_lookups);
+
+   cso_cache_delete(&cache);
+}
+
+int
+main(int argc, char **argv)
+{
+   replay(4096);
+   replay(512);
+   return 0;
+}
@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+#include "cso_cache.h"
+#include "util/u_memory.h"
+
+namespace {
+
+struct test_state {
+   uint32_t key[16];
+};
+
+struct deleted_list {
+   std::vector<uint32_t> ids;
+};
+
+static void
+delete_test_state(void *ctx, void *state, enum cso_cache_type type)
+{
+   deleted_list *deleted = (deleted_list *)ctx;
+   deleted->ids.push_back(((struct test_state *)state)->key[0]);
+   FREE(state);
+}
+
+static void
+fill_key(uint32_t key[16], uint32_t id)
+{
+   for (unsigned i = 0; i < 16; i++)
+      key[i] = id * 0x9e3779b9u + i;
+   key[0] = id;
+}
+
+static struct test_state *
+find_or_insert(struct cso_cache *sc, uint32_t id, bool *created)
+{
+   uint32_t key[16];
+   fill_key(key, id);
+
+   const uint64_t hash_key = cso_construct_key(key, sizeof(key));
+   struct test_state *state = (struct test_state *)
+      cso_find_state_template(sc, hash_key, CSO_RASTERIZER, key, sizeof(key));
+
+   *created = !state;
+   if (!state) {
+      state = CALLOC_STRUCT(test_state);
+      memcpy(state->key, key, sizeof(key));
+      EXPECT_TRUE(cso_insert_state(sc, hash_key, CSO_RASTERIZER, state));
+   }
+   return state;
+}
+
+class cso_cache_test : public ::testing::Test {
+protected:
+   void SetUp() override
+   {
+      cso_cache_init(&cache, NULL);
+      cso_cache_set_delete_cso_callback(&cache, delete_test_state, &deleted);
+   }
+
+   void TearDown() override
+   {
+      cso_cache_delete(&cache);
+   }
+
+   struct cso_cache cache;
+   deleted_list deleted;
+};
+
+} /* namespace */
+
+TEST_F(cso_cache_test, find_after_insert)
+{
+   bool created;
+
+   for (uint32_t id = 0; id < 1000; id++) {
+      find_or_insert(&cache, id, &created);
+      EXPECT_TRUE(created);
+   }
+
+   for (uint32_t id = 0; id < 1000; id++) {
+      struct test_state *state = find_or_insert(&cache, id, &created);
+      EXPECT_FALSE(created);
+      EXPECT_EQ(state->key[0], id);
+   }
+
+   EXPECT_EQ(cache.tables[CSO_RASTERIZER].count, 1000u);
+   EXPECT_EQ(cache.tables[CSO_BLEND].count, 0u);
+   EXPECT_TRUE(deleted.ids.empty());
+}
+
+TEST_F(cso_cache_test, evicts_least_recently_used)
+{
+   bool created;
+
+   cso_set_maximum_cache_size(&cache, 16);
+
+   for (uint32_t id = 0; id < 16; id++)
+      find_or_insert(&cache, id, &created);
+
+   /* Use the first half again, so the second half is older. */
+   for (uint32_t id = 0; id < 8; id++)
+      find_or_insert(&cache, id, &created);
+
+   /* Once over the limit, the cache drops a fourth of its states plus the
+    * excess, oldest first.
+    */
+   find_or_insert(&cache, 100, &created);
+   EXPECT_TRUE(deleted.ids.empty());
+   find_or_insert(&cache, 101, &created);
+   ASSERT_EQ(deleted.ids.size(), 5u);
+   for (uint32_t id : deleted.ids)
+      EXPECT_TRUE(id >= 8 && id < 13);
+
+   for (uint32_t id = 0; id < 8; id++) {
+      find_or_insert(&cache, id, &created);
+      EXPECT_FALSE(created);
+   }
+   EXPECT_EQ(cache.tables[CSO_RASTERIZER].count, 13u);
+}
+
+static bool
+keep_even_states(void *user_data, void *state, enum cso_cache_type type)
+{
+   struct cso_cache *sc = (struct cso_cache *)user_data;
+
+   if (((struct test_state *)state)->key[0] % 2 == 0)
+      return false;
+
+   sc->delete_cso(sc->delete_cso_ctx, state, type);
+   return true;
+}
+
+TEST_F(cso_cache_test, evict_skips_states_in_use)
+{
+   bool created;
+
+   for (uint32_t id = 0; id < 10; id++)
+      find_or_insert(&cache, id, &created);
+
+   cso_cache_evict_lru(&cache, CSO_RASTERIZER, 3, keep_even_states, &cache);
+
+   ASSERT_EQ(deleted.ids.size(), 3u);
+   EXPECT_EQ(deleted.ids[0], 1u);
+   EXPECT_EQ(deleted.ids[1], 3u);
+   EXPECT_EQ(deleted.ids[2], 5u);
+
+   /* Evicted slots must not hide states stored past them. */
+   for (uint32_t id = 0; id < 10; id++) {
+      find_or_insert(&cache, id, &created);
+      EXPECT_EQ(created, id == 1 || id == 3 || id == 5);
+   }
+}
+
+/* A state sequence shaped like a state-thrashing GL app: a small hot set
+ * rebound every draw, a larger warm set, and a trickle of new states.
+ */
+static std::vector<uint32_t>
+replay_sequence(unsigned num_lookups)
+{
+   std::vector<uint32_t> sequence(num_lookups);
+   uint32_t seed = 1;
+   uint32_t next_new = 1 << 16;
+
+   for (unsigned i = 0; i < num_lookups; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      unsigned r = seed >> 8;
+
+      if (r % 100 < 80)
+         sequence[i] = r % 32;
+      else if (r % 100 < 99)
+         sequence[i] = 32 + r % 2048;
+      else
+         sequence[i] = next_new++;
+   }
+   return sequence;
+}
+
+TEST_F(cso_cache_test, replay_hits)
+{
+   const std::vector<uint32_t> sequence = replay_sequence(1 << 14);
+   const std::set<uint32_t> distinct(sequence.begin(), sequence.end());
+   unsigned misses = 0;
+   bool created;
+
+   /* Everything fits into the default cache size, so only the first use of
+    * each state misses.
+    */
+   for (uint32_t id : sequence) {
+      find_or_insert(&cache, id, &created);
+      misses += created;
+   }
+   EXPECT_EQ(misses, distinct.size());
+   EXPECT_EQ(cache.tables[CSO_RASTERIZER].count, distinct.size());
+
+   misses = 0;
+   for (uint32_t id : sequence) {
+      find_or_insert(&cache, id, &created);
+      misses += created;
+   }
+   EXPECT_EQ(misses, 0u);
+   EXPECT_TRUE(deleted.ids.empty());
+}
+
+TEST_F(cso_cache_test, replay_keeps_hot_states)
+{
+   const std::vector<uint32_t> sequence = replay_sequence(1 << 14);
+   unsigned num_created = 0, misses = 0, hot_misses = 0;
+   bool created;
+
+   cso_set_maximum_cache_size(&cache, 512);
+
+   for (uint32_t id : sequence) {
+      find_or_insert(&cache, id, &created);
+      num_created += created;
+   }
+
+   /* The warm set does not fit anymore, but the hot set is used far too
+    * often to ever be the least recently used.
+    */
+   for (uint32_t id : sequence) {
+      find_or_insert(&cache, id, &created);
+      misses += created;
+      hot_misses += created && id < 32;
+   }
+   num_created += misses;
+   EXPECT_GT(misses, 0u);
+   EXPECT_EQ(hot_misses, 0u);
+   EXPECT_EQ(deleted.ids.size() + cache.tables[CSO_RASTERIZER].count,
+             num_created);
+}
@@ -46,7 +46,6 @@
 
 #include "cso_cache/cso_context.h"
 #include "cso_cache/cso_cache.h"
-#include "cso_cache/cso_hash.h"
 #include "cso_context.h"
 #include "driver_trace/tr_dump.h"
 #include "util/u_threaded_context.h"
@@ -152,6 +151,7 @@ delete_cso(struct cso_context_priv *ctx,
       if (ctx->velements == ((struct cso_velements*)state)->data ||
           ctx->velements_saved == ((struct cso_velements*)state)->data)
          return false;
+      ctx->base.velems_epoch++;
       break;
    case CSO_SAMPLER:
       /* nothing to do for samplers */
@@ -165,81 +165,62 @@ delete_cso(struct cso_context_priv *ctx,
 }
 
 
-static inline void
-sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
-              int max_size, void *user_data)
+static bool
+evict_cso(void *user_data, void *state, enum cso_cache_type type)
 {
    struct cso_context_priv *ctx = (struct cso_context_priv *)user_data;
-   /* if we're approach the maximum size, remove fourth of the entries
-    * otherwise every subsequent call will go through the same */
-   const int hash_size = cso_hash_size(hash);
-   const int max_entries = (max_size > hash_size) ? max_size : hash_size;
-   int to_remove =  (max_size < max_entries) * max_entries/4;
-   struct cso_sampler **samplers_to_restore = NULL;
-   unsigned to_restore = 0;
 
-   if (hash_size > max_size)
-      to_remove += hash_size - max_size;
+   if (type == CSO_SAMPLER && ((struct cso_sampler *)state)->pinned)
+      return false;
 
-   if (to_remove == 0)
-      return;
+   return delete_cso(ctx, state, type);
+}
 
-   if (type == CSO_SAMPLER) {
-      samplers_to_restore = MALLOC((MESA_SHADER_MESH_STAGES + 2) * PIPE_MAX_SAMPLERS *
-                                   sizeof(*samplers_to_restore));
 
-      /* Temporarily remove currently bound sampler states from the hash
-       * table, to prevent them from being deleted
-       */
-      for (int i = 0; i < MESA_SHADER_MESH_STAGES; i++) {
-         for (int j = 0; j < PIPE_MAX_SAMPLERS; j++) {
-            struct cso_sampler *sampler = ctx->samplers[i].cso_samplers[j];
-
-            if (sampler && cso_hash_take(hash, sampler->hash_key))
-               samplers_to_restore[to_restore++] = sampler;
-         }
-      }
+static void
+pin_samplers(struct cso_context_priv *ctx, bool pinned)
+{
+   for (int i = 0; i < MESA_SHADER_MESH_STAGES; i++) {
       for (int j = 0; j < PIPE_MAX_SAMPLERS; j++) {
-         struct cso_sampler *sampler = ctx->fragment_samplers_saved.cso_samplers[j];
+         struct cso_sampler *sampler = ctx->samplers[i].cso_samplers[j];
 
-         if (sampler && cso_hash_take(hash, sampler->hash_key))
-            samplers_to_restore[to_restore++] = sampler;
+         if (sampler)
+            sampler->pinned = pinned;
       }
-      for (int j = 0; j < PIPE_MAX_SAMPLERS; j++) {
-         struct cso_sampler *sampler = ctx->compute_samplers_saved.cso_samplers[j];
+   }
+   for (int j = 0; j < PIPE_MAX_SAMPLERS; j++) {
+      struct cso_sampler *sampler = ctx->fragment_samplers_saved.cso_samplers[j];
 
-         if (sampler && cso_hash_take(hash, sampler->hash_key))
-            samplers_to_restore[to_restore++] = sampler;
-      }
+      if (sampler)
+         sampler->pinned = pinned;
    }
+   for (int j = 0; j < PIPE_MAX_SAMPLERS; j++) {
+      struct cso_sampler *sampler = ctx->compute_samplers_saved.cso_samplers[j];
 
-   struct cso_hash_iter iter = cso_hash_first_node(hash);
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      void *cso = cso_hash_iter_data(iter);
+      if (sampler)
+         sampler->pinned = pinned;
+   }
+}
 
-      if (!cso)
-         break;
 
-      if (delete_cso(ctx, cso, type)) {
-         iter = cso_hash_erase(hash, iter);
-         --to_remove;
-      } else {
-         iter = cso_hash_iter_next(iter);
-      }
-   }
+static void
+sanitize_hash(struct cso_cache *sc, enum cso_cache_type type,
+              int max_size, void *user_data)
+{
+   struct cso_context_priv *ctx = (struct cso_context_priv *)user_data;
+   const unsigned to_remove = cso_cache_num_to_evict(sc, type, max_size);
 
-   if (type == CSO_SAMPLER) {
-      /* Put currently bound sampler states back into the hash table */
-      while (to_restore--) {
-         struct cso_sampler *sampler = samplers_to_restore[to_restore];
+   if (to_remove == 0)
+      return;
 
-         cso_hash_insert(hash, sampler->hash_key, sampler);
-      }
+   /* Currently bound sampler states must not be deleted. */
+   if (type == CSO_SAMPLER)
+      pin_samplers(ctx, true);
 
-      FREE(samplers_to_restore);
-   }
+   cso_cache_evict_lru(sc, type, to_remove, evict_cso, ctx);
+
+   if (type == CSO_SAMPLER)
+      pin_samplers(ctx, false);
 }
 
 
@@ -506,8 +487,9 @@ cso_set_blend(struct cso_context *cso,
               const struct pipe_blend_state *templ)
 {
    struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
-   unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   unsigned key_size;
+   uint64_t hash_key;
+   struct cso_blend *found;
    void *handle;
 
    if (templ->independent_blend_enable) {
@@ -516,17 +498,17 @@ cso_set_blend(struct cso_context *cso,
        * be inlined and unrolled.
        */
       hash_key = cso_construct_key(templ, CSO_BLEND_KEY_SIZE_ALL_RT);
-      iter = cso_find_state_template(&ctx->cache, hash_key, CSO_BLEND,
-                                     templ, CSO_BLEND_KEY_SIZE_ALL_RT);
+      found = cso_find_state_template(&ctx->cache, hash_key, CSO_BLEND,
+                                      templ, CSO_BLEND_KEY_SIZE_ALL_RT);
       key_size = CSO_BLEND_KEY_SIZE_ALL_RT;
    } else {
       hash_key = cso_construct_key(templ, CSO_BLEND_KEY_SIZE_RT0);
-      iter = cso_find_state_template(&ctx->cache, hash_key, CSO_BLEND,
-                                     templ, CSO_BLEND_KEY_SIZE_RT0);
+      found = cso_find_state_template(&ctx->cache, hash_key, CSO_BLEND,
+                                      templ, CSO_BLEND_KEY_SIZE_RT0);
       key_size = CSO_BLEND_KEY_SIZE_RT0;
    }
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!found) {
       struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
@@ -535,15 +517,14 @@ cso_set_blend(struct cso_context *cso,
       memcpy(&cso->state, templ, key_size);
       cso->data = ctx->base.pipe->create_blend_state(ctx->base.pipe, &cso->state);
 
-      iter = cso_insert_state(&ctx->cache, hash_key, CSO_BLEND, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(&ctx->cache, hash_key, CSO_BLEND, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
 
       handle = cso->data;
    } else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
+      handle = found->data;
    }
 
    if (ctx->blend != handle) {
@@ -579,14 +560,13 @@ cso_set_depth_stencil_alpha(struct cso_context *cso,
 {
    struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
    const unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   const unsigned hash_key = cso_construct_key(templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(&ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       templ, key_size);
+   const uint64_t hash_key = cso_construct_key(templ, key_size);
+   struct cso_depth_stencil_alpha *found =
+      cso_find_state_template(&ctx->cache, hash_key, CSO_DEPTH_STENCIL_ALPHA,
+                              templ, key_size);
    void *handle;
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!found) {
       struct cso_depth_stencil_alpha *cso =
          MALLOC(sizeof(struct cso_depth_stencil_alpha));
       if (!cso)
@@ -596,17 +576,15 @@ cso_set_depth_stencil_alpha(struct cso_context *cso,
       cso->data = ctx->base.pipe->create_depth_stencil_alpha_state(ctx->base.pipe,
                                                               &cso->state);
 
-      iter = cso_insert_state(&ctx->cache, hash_key,
-                              CSO_DEPTH_STENCIL_ALPHA, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(&ctx->cache, hash_key,
+                            CSO_DEPTH_STENCIL_ALPHA, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
 
       handle = cso->data;
    } else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
+      handle = found->data;
    }
 
    if (ctx->depth_stencil != handle) {
@@ -643,11 +621,10 @@ cso_set_rasterizer(struct cso_context *cso,
 {
    struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
    const unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   const unsigned hash_key = cso_construct_key(templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(&ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       templ, key_size);
+   const uint64_t hash_key = cso_construct_key(templ, key_size);
+   struct cso_rasterizer *found =
+      cso_find_state_template(&ctx->cache, hash_key, CSO_RASTERIZER,
+                              templ, key_size);
    void *handle = NULL;
 
    /* We can't have both point_quad_rasterization (sprites) and point_smooth
@@ -655,7 +632,7 @@ cso_set_rasterizer(struct cso_context *cso,
     */
    assert(!(templ->point_quad_rasterization && templ->point_smooth));
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!found) {
       struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
@@ -663,15 +640,14 @@ cso_set_rasterizer(struct cso_context *cso,
       memcpy(&cso->state, templ, sizeof(*templ));
       cso->data = ctx->base.pipe->create_rasterizer_state(ctx->base.pipe, &cso->state);
 
-      iter = cso_insert_state(&ctx->cache, hash_key, CSO_RASTERIZER, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(&ctx->cache, hash_key, CSO_RASTERIZER, cso)) {
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
 
       handle = cso->data;
    } else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
+      handle = found->data;
    }
 
    if (ctx->rasterizer != handle) {
@@ -1256,12 +1232,12 @@ cso_get_vertex_elements(struct cso_context_priv *ctx,
     */
    const unsigned key_size =
       sizeof(struct pipe_vertex_element) * velems->count + sizeof(unsigned);
-   const unsigned hash_key = cso_construct_key((void*)velems, key_size);
-   struct cso_hash_iter iter =
+   const uint64_t hash_key = cso_construct_key((void*)velems, key_size);
+   struct cso_velements *found =
       cso_find_state_template(&ctx->cache, hash_key, CSO_VELEMENTS,
                               velems, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!found) {
       struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
       if (!cso)
          return NULL;
@@ -1277,15 +1253,14 @@ cso_get_vertex_elements(struct cso_context_priv *ctx,
       cso->data = ctx->base.pipe->create_vertex_elements_state(ctx->base.pipe, new_count,
                                                           new_elems);
 
-      iter = cso_insert_state(&ctx->cache, hash_key, CSO_VELEMENTS, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(&ctx->cache, hash_key, CSO_VELEMENTS, cso)) {
          FREE(cso);
          return NULL;
       }
 
       return cso->data;
    } else {
-      return ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      return found->data;
    }
 }
 
@@ -1312,6 +1287,32 @@ cso_get_vertex_elements_for_bind(struct cso_context *cso,
    struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
    void *handle = cso_get_vertex_elements(ctx, velems);
 
+   return cso_get_vertex_elements_handle_for_bind(cso, handle);
+}
+
+/**
+ * Return the driver vertex elements state for \p velems without binding it.
+ * The caller can keep the handle and bind it later with
+ * cso_get_vertex_elements_handle_for_bind as long as
+ * cso_context::velems_epoch doesn't change.
+ */
+void *
+cso_get_vertex_elements_handle(struct cso_context *cso,
+                               const struct cso_velems_state *velems)
+{
+   return cso_get_vertex_elements((struct cso_context_priv *)cso, velems);
+}
+
+/**
+ * Same as cso_get_vertex_elements_for_bind, but for a handle returned by
+ * cso_get_vertex_elements_handle.
+ */
+void *
+cso_get_vertex_elements_handle_for_bind(struct cso_context *cso,
+                                        void *handle)
+{
+   struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
+
    if (handle && ctx->velements != handle) {
       ctx->velements = handle;
       return handle;
@@ -1438,34 +1439,63 @@ cso_set_vertex_buffers_and_elements(struct cso_context *cso,
 }
 
 
+/**
+ * Let u_vbuf keep translated vertices across draws. The caller must report
+ * all writes to vertex buffers with cso_invalidate_translated_vertex_buffers.
+ * Returns false if the context doesn't use u_vbuf, in which case nothing
+ * has to be reported.
+ */
+bool
+cso_enable_translated_vertex_cache(struct cso_context *cso)
+{
+   struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
+
+   if (!ctx->vbuf)
+      return false;
+
+   u_vbuf_enable_translated_buffer_cache(ctx->vbuf);
+   return true;
+}
+
+
+/**
+ * Drop the translated vertices of \p buffer, or all of them if NULL.
+ */
+void
+cso_invalidate_translated_vertex_buffers(struct cso_context *cso,
+                                         struct pipe_resource *buffer)
+{
+   struct cso_context_priv *ctx = (struct cso_context_priv *)cso;
+
+   if (ctx->vbuf)
+      u_vbuf_invalidate_translated_buffers(ctx->vbuf, buffer);
+}
+
+
 ALWAYS_INLINE static struct cso_sampler *
 set_sampler(struct cso_context_priv *ctx, mesa_shader_stage shader_stage,
             unsigned idx, const struct pipe_sampler_state *templ,
             size_t key_size)
 {
-   unsigned hash_key = cso_construct_key(templ, key_size);
-   struct cso_sampler *cso;
-   struct cso_hash_iter iter =
+   uint64_t hash_key = cso_construct_key(templ, key_size);
+   struct cso_sampler *cso =
       cso_find_state_template(&ctx->cache,
                               hash_key, CSO_SAMPLER,
                               templ, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!cso) {
       cso = MALLOC(sizeof(struct cso_sampler));
       if (!cso)
          return NULL;
 
       memcpy(&cso->state, templ, sizeof(*templ));
       cso->data = ctx->base.pipe->create_sampler_state(ctx->base.pipe, &cso->state);
-      cso->hash_key = hash_key;
+      cso->pinned = false;
 
-      iter = cso_insert_state(&ctx->cache, hash_key, CSO_SAMPLER, cso);
-      if (cso_hash_iter_is_null(iter)) {
+      if (!cso_insert_state(&ctx->cache, hash_key, CSO_SAMPLER, cso)) {
          FREE(cso);
          return NULL;
       }
-   } else {
-      cso = cso_hash_iter_data(iter);
    }
    return cso;
 }
@@ -44,6 +44,12 @@ struct cso_context {
 
    /* This is equal to either pipe_context::draw_vbo or u_vbuf_draw_vbo. */
    pipe_draw_func draw_vbo;
+
+   /* Incremented whenever a vertex elements state is evicted from the cache.
+    * Handles returned by cso_get_vertex_elements_handle stay valid while
+    * this doesn't change.
+    */
+   unsigned velems_epoch;
 };
 
 #define CSO_NO_USER_VERTEX_BUFFERS (1 << 0)
@@ -92,6 +98,14 @@ void *
 cso_get_vertex_elements_for_bind(struct cso_context *cso,
                                  const struct cso_velems_state *velems);
 
+void *
+cso_get_vertex_elements_handle(struct cso_context *cso,
+                               const struct cso_velems_state *velems);
+
+void *
+cso_get_vertex_elements_handle_for_bind(struct cso_context *cso,
+                                        void *handle);
+
 enum pipe_error
 cso_set_vertex_elements(struct cso_context *ctx,
                         const struct cso_velems_state *velems);
@@ -219,6 +233,13 @@ cso_set_vertex_buffers_and_elements(struct cso_context *ctx,
                                     bool uses_user_vertex_buffers,
                                     const struct pipe_vertex_buffer *vbuffers);
 
+bool
+cso_enable_translated_vertex_cache(struct cso_context *cso);
+
+void
+cso_invalidate_translated_vertex_buffers(struct cso_context *cso,
+                                         struct pipe_resource *buffer);
+
 void
 cso_draw_arrays_instanced(struct cso_context *cso, unsigned mode,
                           unsigned start, unsigned count,
@@ -52,6 +52,8 @@
 #include "draw_llvm.h"
 #endif
 
+DEBUG_GET_ONCE_NUM_OPTION(draw_vs_threads, "DRAW_VS_THREADS", 0)
+
 
 bool
 draw_get_option_use_llvm(void)
@@ -83,6 +85,7 @@ draw_create_context(struct pipe_context *pipe, void *context,
 
    draw->pipe = pipe;
    draw->constant_buffer_stride = (sizeof(float) * 4);
+   draw->vs_threads = MAX2(debug_get_option_draw_vs_threads(), 0);
 
    if (!draw_init(draw))
       goto err_destroy;
@@ -541,6 +544,17 @@ draw_enable_line_stipple(struct draw_context *draw, bool enable)
 }
 
 
+/**
+ * Set the number of worker threads the LLVM vertex shader may use to split
+ * up large draws. Zero runs the vertex shader on the calling thread only.
+ */
+void
+draw_set_vs_threads(struct draw_context *draw, unsigned num_threads)
+{
+   draw->vs_threads = num_threads;
+}
+
+
 /**
  * Tells draw module whether to convert points to quads for sprite mode.
  */
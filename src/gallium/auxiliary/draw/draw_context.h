@@ -43,6 +43,10 @@
 #include "util/mesa-blake3.h"
 #include "nir.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct pipe_context;
 struct draw_context;
 struct draw_stage;
@@ -145,6 +149,8 @@ void draw_enable_line_stipple(struct draw_context *draw, bool enable);
 
 void draw_enable_point_sprites(struct draw_context *draw, bool enable);
 
+void draw_set_vs_threads(struct draw_context *draw, unsigned num_threads);
+
 void draw_set_zs_format(struct draw_context *draw, enum pipe_format format);
 
 /* for TGSI constants are 4 * sizeof(float), but for NIR they need to be sizeof(float); */
@@ -428,5 +434,8 @@ draw_set_disk_cache_callbacks(struct draw_context *draw,
                                                     struct lp_cached_code *cache,
                                                     unsigned char ir_blake3_cache_key[BLAKE3_KEY_LEN]));
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* DRAW_CONTEXT_H */
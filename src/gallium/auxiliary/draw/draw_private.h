@@ -398,6 +398,9 @@ struct draw_context
    unsigned constant_buffer_stride;
    struct draw_llvm *llvm;
 
+   /** Worker threads the LLVM vertex shader may use on large draws */
+   unsigned vs_threads;
+
    /** Texture sampler and sampler view state.
     * Note that we have arrays indexed by shader type.  At this time
     * we only handle vertex and geometry shaders in the draw module, but
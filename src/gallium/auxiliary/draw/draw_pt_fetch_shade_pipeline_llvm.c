@@ -28,6 +28,8 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_tess.h"
@@ -65,6 +67,32 @@ struct llvm_middle_end {
    struct util_shader_variant *tes_variant_pin;
 };
 
+/* Chunks are a multiple of the widest native vector length, so that the
+ * vertex shader of one chunk never writes past its end into the next one.
+ */
+#define LLVM_VS_CHUNK_ALIGN 16
+#define LLVM_VS_MIN_CHUNK   256
+#define LLVM_VS_MAX_CHUNKS  16
+
+/* Worker threads running the vertex shader on chunks of large draws. They
+ * are shared by all draw contexts of the process and only created once a
+ * context with draw->vs_threads != 0 runs a large enough draw.
+ */
+static struct util_queue llvm_vs_queue;
+static once_flag llvm_vs_queue_once = ONCE_FLAG_INIT;
+static bool llvm_vs_queue_ok;
+
+struct llvm_vs_job {
+   struct util_queue_fence fence;
+   struct llvm_middle_end *fpme;
+   struct vertex_header *verts;
+   unsigned count;
+   unsigned start;
+   unsigned vertex_id_offset;
+   const unsigned *elts;
+   bool clipped;
+};
+
 
 /** cast wrapper */
 static inline struct llvm_middle_end *
@@ -312,6 +340,132 @@ emit(struct pt_emit *emit,
 }
 
 
+static void
+llvm_vs_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct llvm_vs_job *job = data;
+   struct llvm_middle_end *fpme = job->fpme;
+   struct draw_context *draw = fpme->draw;
+
+   job->clipped = fpme->current_variant->jit_func(&fpme->llvm->vs_jit_context,
+                                                  &fpme->llvm->jit_resources[MESA_SHADER_VERTEX],
+                                                  job->verts,
+                                                  draw->pt.user.vbuffer,
+                                                  job->count,
+                                                  job->start,
+                                                  fpme->vertex_size,
+                                                  draw->pt.vertex_buffer,
+                                                  draw->instance_id,
+                                                  job->vertex_id_offset,
+                                                  draw->start_instance,
+                                                  job->elts,
+                                                  draw->pt.user.drawid,
+                                                  draw->pt.user.viewid);
+}
+
+
+/* Worker threads don't inherit the denorm flushing that draw_vbo() sets
+ * up on the calling thread, so set it up around each job.
+ */
+static void
+llvm_vs_job_execute_threaded(void *data, void *gdata, int thread_index)
+{
+   unsigned fpstate = util_fpstate_get();
+
+   util_fpstate_set_denorms_to_zero(fpstate);
+   llvm_vs_job_execute(data, gdata, thread_index);
+   util_fpstate_set(fpstate);
+}
+
+
+static void
+llvm_vs_queue_create(void)
+{
+   /* The calling thread runs a chunk as well. */
+   unsigned num_threads = MIN2(util_get_cpu_caps()->nr_cpus - 1,
+                               LLVM_VS_MAX_CHUNKS - 1);
+
+   llvm_vs_queue_ok =
+      util_queue_init(&llvm_vs_queue, "drawvs", LLVM_VS_MAX_CHUNKS,
+                      MAX2(num_threads, 1), UTIL_QUEUE_INIT_RESIZE_IF_FULL,
+                      NULL);
+}
+
+
+static bool
+llvm_vs_queue_init(void)
+{
+   call_once(&llvm_vs_queue_once, llvm_vs_queue_create);
+   return llvm_vs_queue_ok;
+}
+
+
+/**
+ * Run fetch and the vertex shader. Large draws are split into chunks which
+ * run on the worker threads and the calling thread. Each chunk writes its
+ * own range of the output vertices, so the order of the vertices (and
+ * therefore of the emitted primitives) is the same as with a single call.
+ */
+static bool
+llvm_pipeline_run_vs(struct llvm_middle_end *fpme,
+                     struct vertex_header *verts,
+                     unsigned count,
+                     unsigned start,
+                     unsigned vertex_id_offset,
+                     const unsigned *elts)
+{
+   struct llvm_vs_job jobs[LLVM_VS_MAX_CHUNKS];
+   unsigned num_chunks = MIN3(count / LLVM_VS_MIN_CHUNK,
+                              fpme->draw->vs_threads + 1, LLVM_VS_MAX_CHUNKS);
+
+   if (num_chunks <= 1 || !llvm_vs_queue_init()) {
+      struct llvm_vs_job job = {
+         .fpme = fpme,
+         .verts = verts,
+         .count = count,
+         .start = start,
+         .vertex_id_offset = vertex_id_offset,
+         .elts = elts,
+      };
+      llvm_vs_job_execute(&job, NULL, 0);
+      return job.clipped;
+   }
+
+   unsigned chunk_size = align(DIV_ROUND_UP(count, num_chunks), LLVM_VS_CHUNK_ALIGN);
+   num_chunks = DIV_ROUND_UP(count, chunk_size);
+
+   for (unsigned i = 0; i < num_chunks; i++) {
+      unsigned offset = i * chunk_size;
+      struct llvm_vs_job *job = &jobs[i];
+
+      job->fpme = fpme;
+      job->verts = (struct vertex_header *)((char *)verts + offset * fpme->vertex_size);
+      job->count = MIN2(chunk_size, count - offset);
+      /* With elts, start is the max element index, not a vertex offset. */
+      job->start = elts ? start : start + offset;
+      job->vertex_id_offset = vertex_id_offset;
+      job->elts = elts ? elts + offset : NULL;
+      job->clipped = false;
+      util_queue_fence_init(&job->fence);
+
+      /* The calling thread runs the last chunk. */
+      if (i < num_chunks - 1)
+         util_queue_add_job(&llvm_vs_queue, job, &job->fence,
+                            llvm_vs_job_execute_threaded, NULL, 0);
+   }
+
+   llvm_vs_job_execute(&jobs[num_chunks - 1], NULL, 0);
+
+   bool clipped = false;
+   for (unsigned i = 0; i < num_chunks; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+      clipped |= jobs[i].clipped;
+   }
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -376,20 +530,9 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
          elts = fetch_info->elts;
       }
       /* Run vertex fetch shader */
-      clipped = fpme->current_variant->jit_func(&fpme->llvm->vs_jit_context,
-                                                &fpme->llvm->jit_resources[MESA_SHADER_VERTEX],
-                                                llvm_vert_info.verts,
-                                                draw->pt.user.vbuffer,
-                                                fetch_info->count,
-                                                start,
-                                                fpme->vertex_size,
-                                                draw->pt.vertex_buffer,
-                                                draw->instance_id,
-                                                vertex_id_offset,
-                                                draw->start_instance,
-                                                elts,
-                                                draw->pt.user.drawid,
-                                                draw->pt.user.viewid);
+      clipped = llvm_pipeline_run_vs(fpme, llvm_vert_info.verts,
+                                     fetch_info->count, start,
+                                     vertex_id_offset, elts);
 
       /* Finished with fetch and vs */
       fetch_info = NULL;
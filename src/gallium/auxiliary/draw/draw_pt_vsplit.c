@@ -28,13 +28,26 @@
 #include "util/macros.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_debug.h"
 
 #include "draw/draw_context.h"
 #include "draw/draw_private.h"
 #include "draw/draw_pt.h"
 
 #define SEGMENT_SIZE 1024
-#define MAP_SIZE     256
+
+/* The vertex cache maps fetch elements to draw elements within a segment.
+ * It is MAP_WAYS-way set-associative with LRU replacement; the number of
+ * entries can be set with DRAW_VSPLIT_CACHE_SIZE. A segment has at most
+ * SEGMENT_SIZE distinct fetches, so a bigger cache is never useful.
+ */
+#define MAP_WAYS         4
+#define MAP_SIZE_DEFAULT 512
+#define MAP_SIZE_MIN     (2 * MAP_WAYS)
+#define MAP_SIZE_MAX     SEGMENT_SIZE
+
+DEBUG_GET_ONCE_NUM_OPTION(draw_vsplit_cache_size, "DRAW_VSPLIT_CACHE_SIZE", MAP_SIZE_DEFAULT)
+DEBUG_GET_ONCE_BOOL_OPTION(draw_vsplit_stats, "DRAW_VSPLIT_STATS", false)
 
 struct vsplit_frontend {
    struct draw_pt_front_end base;
@@ -53,21 +66,34 @@ struct vsplit_frontend {
    uint16_t identity_draw_elts[SEGMENT_SIZE];
 
    struct {
-      /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      uint16_t draws[MAP_SIZE];
+      /* map a fetch element to a draw element, MAP_WAYS entries per set
+       * with the most recently used first
+       */
+      unsigned fetches[MAP_SIZE_MAX];
+      uint16_t draws[MAP_SIZE_MAX];
+      unsigned size;
+      unsigned set_mask;
       bool has_max_fetch;
 
       uint16_t num_fetch_elts;
       uint16_t num_draw_elts;
    } cache;
+
+   /* DRAW_VSPLIT_STATS: vertices shaded vs. indices of the current draw */
+   struct {
+      void (*run)(struct draw_pt_front_end *frontend,
+                  unsigned start, unsigned count);
+      uint64_t num_fetch_elts;
+      uint64_t num_draw_elts;
+   } stats;
 };
 
 
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
+   memset(vsplit->cache.fetches, 0xff,
+          vsplit->cache.size * sizeof(vsplit->cache.fetches[0]));
    vsplit->cache.has_max_fetch = false;
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
@@ -77,6 +103,9 @@ vsplit_clear_cache(struct vsplit_frontend *vsplit)
 static void
 vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned start, unsigned flags)
 {
+   vsplit->stats.num_fetch_elts += vsplit->cache.num_fetch_elts;
+   vsplit->stats.num_draw_elts += vsplit->cache.num_draw_elts;
+
    vsplit->middle->run(vsplit->middle, start,
          vsplit->fetch_elts, vsplit->cache.num_fetch_elts,
          vsplit->draw_elts, vsplit->cache.num_draw_elts, flags);
@@ -89,23 +118,58 @@ vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned start, unsigned flag
 static inline void
 vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch)
 {
-   unsigned hash;
-
-   hash = fetch % MAP_SIZE;
+   unsigned set = (fetch & vsplit->cache.set_mask) * MAP_WAYS;
+   unsigned *fetches = &vsplit->cache.fetches[set];
+   uint16_t *draws = &vsplit->cache.draws[set];
+   uint16_t draw;
+   unsigned way;
+
+   for (way = 0; way < MAP_WAYS; way++) {
+      if (fetches[way] == fetch)
+         break;
+   }
 
    /* If the value isn't in the cache or it's an overflow due to the
     * element bias */
-   if (vsplit->cache.fetches[hash] != fetch) {
-      /* update cache */
-      vsplit->cache.fetches[hash] = fetch;
-      vsplit->cache.draws[hash] = vsplit->cache.num_fetch_elts;
+   if (way == MAP_WAYS) {
+      /* evict the least recently used entry */
+      way = MAP_WAYS - 1;
+      draw = vsplit->cache.num_fetch_elts;
 
       /* add fetch */
       assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
       vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
+   } else {
+      draw = draws[way];
+   }
+
+   /* move the entry to the front of its set */
+   for (; way > 0; way--) {
+      fetches[way] = fetches[way - 1];
+      draws[way] = draws[way - 1];
    }
+   fetches[0] = fetch;
+   draws[0] = draw;
 
-   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[hash];
+   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = draw;
+}
+
+
+/**
+ * The cache is cleared to DRAW_MAX_FETCH_IDX, so the first time that index
+ * is seen the empty entries of its set must not match it.
+ */
+static inline void
+vsplit_add_max_fetch(struct vsplit_frontend *vsplit)
+{
+   unsigned set = (DRAW_MAX_FETCH_IDX & vsplit->cache.set_mask) * MAP_WAYS;
+
+   /* force update - any value will do except DRAW_MAX_FETCH_IDX */
+   for (unsigned way = 0; way < MAP_WAYS; way++) {
+      if (vsplit->cache.fetches[set + way] == DRAW_MAX_FETCH_IDX)
+         vsplit->cache.fetches[set + way] = 0;
+   }
+   vsplit->cache.has_max_fetch = true;
 }
 
 
@@ -129,11 +193,8 @@ vsplit_add_cache_uint8(struct vsplit_frontend *vsplit, const uint8_t *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* unlike the uint32_t case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = true;
-   }
+   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_add_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -147,11 +208,8 @@ vsplit_add_cache_uint16(struct vsplit_frontend *vsplit, const uint16_t *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* unlike the uint32_t case this can only happen with elt_bias */
-   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = true;
-   }
+   if (elt_bias && elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_add_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -172,12 +230,8 @@ vsplit_add_cache_uint32(struct vsplit_frontend *vsplit, const uint32_t *elts,
    elt_idx = vsplit_get_base_idx(start, fetch);
    elt_idx = (unsigned)((int)(DRAW_GET_IDX(elts, elt_idx)) + elt_bias);
    /* Take care for DRAW_MAX_FETCH_IDX (since cache is initialized to -1). */
-   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = elt_idx % MAP_SIZE;
-      /* force update - any value will do except DRAW_MAX_FETCH_IDX */
-      vsplit->cache.fetches[hash] = 0;
-      vsplit->cache.has_max_fetch = true;
-   }
+   if (elt_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch)
+      vsplit_add_max_fetch(vsplit);
    vsplit_add_cache(vsplit, elt_idx);
 }
 
@@ -201,6 +255,35 @@ vsplit_add_cache_uint32(struct vsplit_frontend *vsplit, const uint32_t *elts,
 #include "draw_pt_vsplit_tmp.h"
 
 
+/**
+ * Wrapper around the run functions reporting, for every indexed draw, how
+ * many vertices were shaded per index and per vertex of the index range.
+ */
+static void
+vsplit_run_stats(struct draw_pt_front_end *frontend,
+                 unsigned start, unsigned count)
+{
+   struct vsplit_frontend *vsplit = (struct vsplit_frontend *) frontend;
+   struct draw_context *draw = vsplit->draw;
+
+   vsplit->stats.num_fetch_elts = 0;
+   vsplit->stats.num_draw_elts = 0;
+
+   vsplit->stats.run(frontend, start, count);
+
+   if (!vsplit->stats.num_draw_elts)
+      return;
+
+   unsigned range = draw->pt.user.max_index - draw->pt.user.min_index + 1;
+   debug_printf("vsplit: %u indices, %" PRIu64 " vertices shaded, "
+                "%.3f per index, %.3f per vertex in [%u, %u]\n",
+                count, vsplit->stats.num_fetch_elts,
+                (double)vsplit->stats.num_fetch_elts / vsplit->stats.num_draw_elts,
+                range ? (double)vsplit->stats.num_fetch_elts / range : 0.0,
+                draw->pt.user.min_index, draw->pt.user.max_index);
+}
+
+
 static void
 vsplit_prepare(struct draw_pt_front_end *frontend,
                enum mesa_prim in_prim,
@@ -234,6 +317,11 @@ vsplit_prepare(struct draw_pt_front_end *frontend,
    middle->prepare(middle, vsplit->prim, opt, &vsplit->max_vertices);
 
    vsplit->segment_size = MIN2(SEGMENT_SIZE, vsplit->max_vertices);
+
+   if (debug_get_option_draw_vsplit_stats() && vsplit->draw->pt.user.eltSize) {
+      vsplit->stats.run = vsplit->base.run;
+      vsplit->base.run = vsplit_run_stats;
+   }
 }
 
 
@@ -273,5 +361,10 @@ draw_pt_vsplit(struct draw_context *draw)
    for (unsigned i = 0; i < SEGMENT_SIZE; i++)
       vsplit->identity_draw_elts[i] = i;
 
+   unsigned cache_size = CLAMP(debug_get_option_draw_vsplit_cache_size(),
+                               MAP_SIZE_MIN, MAP_SIZE_MAX);
+   vsplit->cache.size = util_next_power_of_two(cache_size);
+   vsplit->cache.set_mask = vsplit->cache.size / MAP_WAYS - 1;
+
    return &vsplit->base;
 }
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "draw/draw_context.h"
+#include "draw/draw_pipe.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "tgsi/tgsi_text.h"
+
+namespace {
+
+/* Large enough that the vertex shader is split into chunks, and not a
+ * multiple of the chunk alignment.
+ */
+const unsigned num_verts = 10001;
+
+const char vs_text[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL SV[0], VERTEXID\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], GENERIC[0]\n"
+   "IMM[0] FLT32 { 0.5, 0.25, 1.0, 0.0 }\n"
+   "  0: MUL OUT[0].xyz, IN[0], IMM[0].xxxx\n"
+   "  1: MOV OUT[0].w, IMM[0].zzzz\n"
+   "  2: MAD OUT[1].xyz, IN[0].yzxx, IMM[0].yyyy, IMM[0].xxxx\n"
+   "  3: U2F OUT[1].w, SV[0].xxxx\n"
+   "  4: END\n";
+
+/* The last pipeline stage, which records the outputs of every point. */
+struct capture_stage {
+   struct draw_stage stage;
+   std::vector<float> outputs;
+};
+
+static void
+capture_point(struct draw_stage *stage, struct prim_header *header)
+{
+   struct capture_stage *cs = (struct capture_stage *)stage;
+   const struct vertex_header *v = header->v[0];
+
+   for (unsigned i = 0; i < draw_num_shader_outputs(stage->draw); i++)
+      cs->outputs.insert(cs->outputs.end(), v->data[i], v->data[i] + 4);
+}
+
+static void
+capture_flush(struct draw_stage *stage, unsigned flags)
+{
+}
+
+static void
+capture_reset_stipple_counter(struct draw_stage *stage)
+{
+}
+
+static void
+capture_destroy(struct draw_stage *stage)
+{
+}
+
+class draw_vs_threads_test : public ::testing::Test {
+protected:
+   void SetUp() override;
+   void TearDown() override;
+
+   std::vector<float> run(unsigned vs_threads, const std::vector<uint32_t> &elts);
+
+   struct pipe_screen screen = {};
+   struct pipe_context pipe = {};
+   struct pipe_rasterizer_state rast = {};
+   struct capture_stage capture = {};
+   struct draw_context *draw = NULL;
+   struct draw_vertex_shader *vs = NULL;
+   std::vector<float> vertices;
+};
+
+void
+draw_vs_threads_test::SetUp()
+{
+   pipe.screen = &screen;
+   draw = draw_create(&pipe);
+   if (!draw || !draw_get_option_use_llvm())
+      GTEST_SKIP() << "draw module without LLVM";
+
+   struct pipe_viewport_state vp = {};
+   vp.scale[0] = vp.scale[1] = vp.scale[2] = 1.0f;
+   draw_set_viewport_states(draw, 0, 1, &vp);
+
+   rast.point_size = 1.0f;
+   rast.half_pixel_center = true;
+   rast.depth_clip_near = true;
+   rast.depth_clip_far = true;
+   draw_set_rasterizer_state(draw, &rast, &rast);
+
+   capture.stage.draw = draw;
+   capture.stage.name = "capture";
+   capture.stage.point = capture_point;
+   capture.stage.flush = capture_flush;
+   capture.stage.reset_stipple_counter = capture_reset_stipple_counter;
+   capture.stage.destroy = capture_destroy;
+   draw_set_rasterize_stage(draw, &capture.stage);
+
+   struct tgsi_token tokens[256];
+   ASSERT_TRUE(tgsi_text_translate(vs_text, tokens, ARRAY_SIZE(tokens)));
+
+   struct pipe_shader_state state = {};
+   state.type = PIPE_SHADER_IR_TGSI;
+   state.tokens = tokens;
+   vs = draw_create_vertex_shader(draw, &state);
+   ASSERT_NE(vs, nullptr);
+   draw_bind_vertex_shader(draw, vs);
+
+   uint32_t seed = 7;
+   vertices.resize(num_verts * 4);
+   for (float &f : vertices) {
+      seed = seed * 1664525u + 1013904223u;
+      f = (int32_t)seed / 2147483648.0f;
+   }
+
+   struct pipe_vertex_buffer vb = {};
+   vb.is_user_buffer = true;
+   vb.buffer.user = vertices.data();
+   draw_set_vertex_buffers(draw, 1, &vb);
+
+   struct pipe_vertex_element ve = {};
+   ve.src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve.src_stride = 4 * sizeof(float);
+   draw_set_vertex_elements(draw, 1, &ve);
+}
+
+void
+draw_vs_threads_test::TearDown()
+{
+   if (vs) {
+      draw_bind_vertex_shader(draw, NULL);
+      draw_delete_vertex_shader(draw, vs);
+   }
+   draw_destroy(draw);
+}
+
+/**
+ * Draw all vertices as points, indexed with elts unless that is empty, and
+ * return the outputs the pipeline receives.
+ */
+std::vector<float>
+draw_vs_threads_test::run(unsigned vs_threads, const std::vector<uint32_t> &elts)
+{
+   struct pipe_draw_info info = {};
+   info.mode = MESA_PRIM_POINTS;
+   info.instance_count = 1;
+
+   struct pipe_draw_start_count_bias sc = {};
+   sc.count = num_verts;
+
+   if (!elts.empty()) {
+      info.index_size = 4;
+      info.has_user_indices = true;
+      info.index.user = elts.data();
+      info.index_bounds_valid = true;
+      info.min_index = 0;
+      info.max_index = num_verts - 1;
+      draw_set_indexes(draw, elts.data(), 4, elts.size() * 4);
+   }
+
+   draw_set_vs_threads(draw, vs_threads);
+   draw_set_mapped_vertex_buffer(draw, 0, vertices.data(),
+                                 vertices.size() * sizeof(float));
+   capture.outputs.clear();
+   draw_vbo(draw, &info, 0, NULL, &sc, 1, 0);
+   draw_flush(draw);
+   draw_set_mapped_vertex_buffer(draw, 0, NULL, 0);
+   if (!elts.empty())
+      draw_set_indexes(draw, NULL, 0, 0);
+
+   return capture.outputs;
+}
+
+static void
+expect_vertex_ids(const std::vector<float> &outputs, unsigned num_outputs,
+                  const std::vector<uint32_t> &elts)
+{
+   ASSERT_EQ(outputs.size(), num_verts * num_outputs * 4);
+
+   for (unsigned i = 0; i < num_verts; i++) {
+      unsigned id = elts.empty() ? i : elts[i];
+      ASSERT_EQ(outputs[(i * num_outputs + 1) * 4 + 3], (float)id) << "vertex " << i;
+   }
+}
+
+} /* namespace */
+
+TEST_F(draw_vs_threads_test, linear)
+{
+   const std::vector<uint32_t> no_elts;
+   unsigned num_outputs = draw_num_shader_outputs(draw);
+
+   std::vector<float> single = run(0, no_elts);
+   expect_vertex_ids(single, num_outputs, no_elts);
+
+   for (unsigned threads : {1, 3, 15}) {
+      std::vector<float> threaded = run(threads, no_elts);
+      EXPECT_EQ(single, threaded) << threads << " threads";
+   }
+}
+
+TEST_F(draw_vs_threads_test, elts)
+{
+   std::vector<uint32_t> elts(num_verts);
+   unsigned num_outputs = draw_num_shader_outputs(draw);
+
+   for (unsigned i = 0; i < num_verts; i++)
+      elts[i] = (i * 7919) % num_verts;
+
+   std::vector<float> single = run(0, elts);
+   expect_vertex_ids(single, num_outputs, elts);
+
+   for (unsigned threads : {1, 3, 15}) {
+      std::vector<float> threaded = run(threads, elts);
+      EXPECT_EQ(single, threaded) << threads << " threads";
+   }
+}
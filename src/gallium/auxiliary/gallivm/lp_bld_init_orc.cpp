@@ -303,9 +303,19 @@ void lpjit_exit()
    LPJit::jit = nullptr;
 }
 
+/* Module flag set on modules whose object code is served from the
+ * lp_cached_code disk cache.  The object cache is only consulted by the
+ * compile layer, which sits below the IR transform layer, so without it
+ * every cache hit would still pay for the full optimization pipeline.
+ */
+#define LP_CACHED_MODULE_FLAG "lp.cached_object"
+
 LLVMErrorRef module_transform(void *Ctx, LLVMModuleRef mod) {
    struct lp_passmgr *mgr;
 
+   if (llvm::unwrap(mod)->getModuleFlag(LP_CACHED_MODULE_FLAG))
+      return LLVMErrorSuccess;
+
    lp_passmgr_create(mod, &mgr);
 
    lp_passmgr_run(mgr, mod,
@@ -681,6 +691,12 @@ gallivm_compile_module(struct gallivm_state *gallivm)
                    "[-mattr=<-mattr option(s)>]");
    }
 
+   if (gallivm->cache && gallivm->cache->data_size) {
+      /* The object will come from the cache, skip the IR passes. */
+      llvm::unwrap(gallivm->module)->addModuleFlag(llvm::Module::Warning,
+                                                   LP_CACHED_MODULE_FLAG, 1);
+   }
+
    LPJit::add_ir_module_to_jd(gallivm->_ts_context, gallivm->module,
       gallivm->_per_module_jd);
    /* ownership of module is now transferred into orc jit,
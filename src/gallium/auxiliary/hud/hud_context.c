@@ -1329,6 +1329,30 @@ hud_parse_env_var(struct hud_context *hud, struct pipe_screen *screen,
       else if (strcmp(name, "API-thread-num-batches") == 0) {
          hud_thread_counter_install(pane, name, HUD_COUNTER_BATCHES);
       }
+      else if (strcmp(name, "API-thread-batches-per-second") == 0) {
+         hud_thread_counter_install(pane, name, HUD_COUNTER_BATCH_RATE);
+      }
+      else if (strcmp(name, "API-thread-bytes-per-batch") == 0) {
+         hud_thread_counter_install(pane, name, HUD_COUNTER_BATCH_BYTES);
+         pane->type = PIPE_DRIVER_QUERY_TYPE_BYTES;
+      }
+      else if (strcmp(name, "API-thread-stall-time") == 0) {
+         hud_thread_counter_install(pane, name, HUD_COUNTER_STALL_TIME);
+         pane->type = PIPE_DRIVER_QUERY_TYPE_PERCENTAGE;
+      }
+      else if (strcmp(name, "upload-bytes") == 0) {
+         hud_upload_counter_install(pane, name, HUD_UPLOAD_BYTES);
+         pane->type = PIPE_DRIVER_QUERY_TYPE_BYTES;
+      }
+      else if (strcmp(name, "upload-buffers-created") == 0) {
+         hud_upload_counter_install(pane, name, HUD_UPLOAD_BUFFERS_CREATED);
+      }
+      else if (strcmp(name, "upload-buffers-recycled") == 0) {
+         hud_upload_counter_install(pane, name, HUD_UPLOAD_BUFFERS_RECYCLED);
+      }
+      else if (strcmp(name, "upload-recycle-stalls") == 0) {
+         hud_upload_counter_install(pane, name, HUD_UPLOAD_RECYCLE_STALLS);
+      }
       else if (strcmp(name, "main-thread-busy") == 0) {
          hud_thread_busy_install(pane, name, true);
       }
@@ -1655,6 +1679,18 @@ print_help(struct pipe_screen *screen)
    puts("    frametime");
    puts("    cpu");
    puts("    dev (prints render device info)");
+   puts("    API-thread-busy");
+   puts("    API-thread-offloaded-slots");
+   puts("    API-thread-direct-slots");
+   puts("    API-thread-num-syncs");
+   puts("    API-thread-num-batches");
+   puts("    API-thread-batches-per-second");
+   puts("    API-thread-bytes-per-batch");
+   puts("    API-thread-stall-time (percentage of time waiting for the thread)");
+   puts("    upload-bytes");
+   puts("    upload-buffers-created");
+   puts("    upload-buffers-recycled");
+   puts("    upload-recycle-stalls");
 
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
@@ -30,9 +30,11 @@
 
 #include "hud/hud_private.h"
 #include "util/os_time.h"
+#include "util/u_atomic.h"
 #include "util/u_thread.h"
 #include "util/u_memory.h"
 #include "util/u_queue.h"
+#include "util/u_upload_mgr.h"
 #include <stdio.h>
 #include <inttypes.h>
 #if DETECT_OS_WINDOWS
@@ -396,6 +398,11 @@ hud_thread_busy_install(struct hud_pane *pane, const char *name, bool main)
 struct counter_info {
    enum hud_counter counter;
    int64_t last_time;
+
+   /* Last samples of the monotonic counters. */
+   uint64_t last_batches;
+   uint64_t last_batch_bytes;
+   uint64_t last_stall_time_ns;
 };
 
 static unsigned get_counter(struct hud_graph *gr, enum hud_counter counter)
@@ -430,11 +437,74 @@ static unsigned get_counter(struct hud_graph *gr, enum hud_counter counter)
    }
 }
 
+/* Compute the value of a counter from the difference between the monotonic
+ * counters now and at the last sample.
+ */
+static uint64_t
+get_counter_rate(struct counter_info *info, struct util_queue_monitoring *mon,
+                 int64_t elapsed_ns)
+{
+   uint64_t batches = p_atomic_read(&mon->total_batches);
+   uint64_t bytes = p_atomic_read(&mon->total_batch_bytes);
+   uint64_t stall_ns = p_atomic_read(&mon->total_stall_time_ns);
+   uint64_t value;
+
+   switch (info->counter) {
+   case HUD_COUNTER_BATCH_RATE:
+      value = (batches - info->last_batches) * 1000000000 / elapsed_ns;
+      break;
+   case HUD_COUNTER_BATCH_BYTES:
+      value = batches > info->last_batches ?
+         (bytes - info->last_batch_bytes) / (batches - info->last_batches) : 0;
+      break;
+   case HUD_COUNTER_STALL_TIME:
+      value = MIN2((stall_ns - info->last_stall_time_ns) * 100 / elapsed_ns,
+                   100);
+      break;
+   default:
+      assert(0);
+      return 0;
+   }
+
+   info->last_batches = batches;
+   info->last_batch_bytes = bytes;
+   info->last_stall_time_ns = stall_ns;
+   return value;
+}
+
+static void
+query_thread_rate(struct hud_graph *gr, struct counter_info *info,
+                  int64_t now)
+{
+   struct util_queue_monitoring *mon = gr->pane->hud->monitored_queue;
+
+   if (!mon || !mon->queue)
+      return;
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period*1000 <= now) {
+         hud_graph_add_value(gr, get_counter_rate(info, mon,
+                                                  now - info->last_time));
+         info->last_time = now;
+      }
+   } else {
+      /* initialize */
+      get_counter_rate(info, mon, 1);
+      info->last_time = now;
+   }
+}
+
 static void
 query_thread_counter(struct hud_graph *gr, struct pipe_context *pipe)
 {
    struct counter_info *info = gr->query_data;
    int64_t now = os_time_get_nano();
+
+   if (info->counter >= HUD_COUNTER_BATCH_RATE) {
+      query_thread_rate(gr, info, now);
+      return;
+   }
+
    unsigned value = get_counter(gr, info->counter);
 
    if (info->last_time) {
@@ -474,3 +544,90 @@ void hud_thread_counter_install(struct hud_pane *pane, const char *name,
    hud_pane_add_graph(pane, gr);
    hud_pane_set_max_value(pane, 100);
 }
+
+struct upload_counter_info {
+   enum hud_upload_counter counter;
+   uint64_t last_value;
+   int64_t last_time;
+};
+
+static uint64_t
+get_upload_stat(const struct u_upload_mgr *upload,
+                enum hud_upload_counter counter)
+{
+   struct u_upload_stats stats;
+
+   if (!upload)
+      return 0;
+
+   u_upload_get_stats(upload, &stats);
+
+   switch (counter) {
+   case HUD_UPLOAD_BYTES:
+      return stats.bytes_uploaded;
+   case HUD_UPLOAD_BUFFERS_CREATED:
+      return stats.buffers_created;
+   case HUD_UPLOAD_BUFFERS_RECYCLED:
+      return stats.buffers_recycled;
+   case HUD_UPLOAD_RECYCLE_STALLS:
+      return stats.recycle_stalls;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+static void
+query_upload_counter(struct hud_graph *gr, struct pipe_context *pipe)
+{
+   struct upload_counter_info *info = gr->query_data;
+   struct pipe_context *app = gr->pane->hud->record_pipe;
+   int64_t now = os_time_get_nano();
+
+   if (!app)
+      app = pipe;
+
+   /* The counters are cumulative, display the difference per period. */
+   uint64_t value = get_upload_stat(app->stream_uploader, info->counter);
+   if (app->const_uploader != app->stream_uploader)
+      value += get_upload_stat(app->const_uploader, info->counter);
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period*1000 <= now) {
+         hud_graph_add_value(gr, value - info->last_value);
+         info->last_value = value;
+         info->last_time = now;
+      }
+   } else {
+      /* initialize */
+      info->last_value = value;
+      info->last_time = now;
+   }
+}
+
+void hud_upload_counter_install(struct hud_pane *pane, const char *name,
+                                enum hud_upload_counter counter)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+   if (!gr)
+      return;
+
+   strcpy(gr->name, name);
+
+   gr->query_data = CALLOC_STRUCT(upload_counter_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   ((struct upload_counter_info*)gr->query_data)->counter = counter;
+   gr->query_new_value = query_upload_counter;
+
+   /* Don't use free() as our callback as that messes up Gallium's
+    * memory debugger.  Use simple free_query_data() wrapper.
+    */
+   gr->free_query_data = free_query_data;
+
+   hud_pane_add_graph(pane, gr);
+   hud_pane_set_max_value(pane, 100);
+}
@@ -40,6 +40,17 @@ enum hud_counter {
    HUD_COUNTER_DIRECT,
    HUD_COUNTER_SYNCS,
    HUD_COUNTER_BATCHES,
+   /* The following are computed from the monotonic counters. */
+   HUD_COUNTER_BATCH_RATE,
+   HUD_COUNTER_BATCH_BYTES,
+   HUD_COUNTER_STALL_TIME,
+};
+
+enum hud_upload_counter {
+   HUD_UPLOAD_BYTES,
+   HUD_UPLOAD_BUFFERS_CREATED,
+   HUD_UPLOAD_BUFFERS_RECYCLED,
+   HUD_UPLOAD_RECYCLE_STALLS,
 };
 
 struct hud_context {
@@ -174,6 +185,8 @@ void hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index);
 void hud_thread_busy_install(struct hud_pane *pane, const char *name, bool main);
 void hud_thread_counter_install(struct hud_pane *pane, const char *name,
                                 enum hud_counter counter);
+void hud_upload_counter_install(struct hud_pane *pane, const char *name,
+                                enum hud_upload_counter counter);
 void hud_pipe_query_install(struct hud_batch_query_context **pbq,
                             struct hud_pane *pane,
                             const char *name,
@@ -32,13 +32,26 @@ static void translate_byte_to_ushort( const void *in,
                                       UNUSED unsigned restart_index,
                                       void *out )
 {
-   uint8_t *src = (uint8_t *)in + start;
-   uint16_t *dst = out;
-   while (out_nr--) {
-      *dst++ = *src++;
-   }
+   u_index_widen_ubyte((const uint8_t *)in + start, out_nr, out);
+}
+
+#define TRANSLATE_QUADS(name, type, pv) \
+static void name( const void *in, \
+                  unsigned start, \
+                  UNUSED unsigned in_nr, \
+                  unsigned out_nr, \
+                  UNUSED unsigned restart_index, \
+                  void *out ) \
+{ \
+   u_index_quads_to_tris((const type *)in + start, sizeof(type), \
+                         out_nr / 6, pv, out); \
 }
 
+TRANSLATE_QUADS(translate_quads_ushort_first, uint16_t, PV_FIRST)
+TRANSLATE_QUADS(translate_quads_ushort_last, uint16_t, PV_LAST)
+TRANSLATE_QUADS(translate_quads_uint_first, uint32_t, PV_FIRST)
+TRANSLATE_QUADS(translate_quads_uint_last, uint32_t, PV_LAST)
+
 enum mesa_prim
 u_index_prim_type_convert(unsigned hw_mask, enum mesa_prim prim, bool pv_matches)
 {
@@ -149,6 +162,17 @@ u_index_translator(unsigned hw_mask,
       [in_idx][out_idx][in_pv][out_pv][prim_restart][prim];
    *out_nr = u_index_count_converted_indices(hw_mask, in_pv == out_pv, prim, nr);
 
+   /* Use the vectorized splitter for the common quads case. */
+   if (prim == MESA_PRIM_QUADS && *out_prim == MESA_PRIM_TRIANGLES &&
+       in_pv == out_pv && prim_restart == PR_DISABLE) {
+      if (in_index_size == 4)
+         *out_translate = in_pv == PV_FIRST ? translate_quads_uint_first :
+                                              translate_quads_uint_last;
+      else if (in_index_size == 2)
+         *out_translate = in_pv == PV_FIRST ? translate_quads_ushort_first :
+                                              translate_quads_ushort_last;
+   }
+
    return ret;
 }
 
@@ -28,6 +28,10 @@
 #include "util/compiler.h"
 #include "pipe/p_defines.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* First/last provoking vertex */
 #define PV_FIRST      0
 #define PV_LAST       1
@@ -139,6 +143,37 @@ u_index_generator(unsigned hw_mask,
                   u_generate_func *out_generate);
 
 
+/**
+ * Vectorized index helpers, used by the translators above and by the
+ * primitive restart emulation in u_prim_restart.c.
+ */
+
+/* Returns the position of the first restart index in the first nr indices,
+ * or nr if there is none.
+ */
+unsigned
+u_index_find_restart(const void *in, unsigned index_size, unsigned nr,
+                     unsigned restart_index);
+
+/* Copies nr indices, replacing restart_index by the all-ones value of the
+ * output size.  1-byte indices are widened to 2 bytes.
+ */
+void
+u_index_remap_restart(const void *in, unsigned index_size, unsigned nr,
+                      unsigned restart_index, void *out);
+
+/* Widens nr 1-byte indices to 2 bytes. */
+void
+u_index_widen_ubyte(const uint8_t *in, unsigned nr, uint16_t *out);
+
+/* Splits nr_quads quads of 2 or 4-byte indices into two triangles each,
+ * keeping the provoking vertex convention.
+ */
+void
+u_index_quads_to_tris(const void *in, unsigned index_size, unsigned nr_quads,
+                      unsigned pv, void *out);
+
+
 void u_unfilled_init( void );
 
 /**
@@ -170,4 +205,8 @@ u_unfilled_generator(enum mesa_prim prim,
                      unsigned *out_nr,
                      u_generate_func *out_generate);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
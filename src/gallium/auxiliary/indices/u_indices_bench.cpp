@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: MIT */
+
+/* Measures the vectorized index helpers against the generated C
+ * translators they replace. Not run as part of the test suite.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "u_indices.h"
+#include "util/os_time.h"
+
+static const unsigned nr = 1 << 20;
+static const unsigned iterations = 16;
+
+static std::vector<uint8_t>
+random_indices(unsigned index_size, uint32_t max, uint32_t seed)
+{
+   std::vector<uint8_t> data(nr * index_size);
+
+   for (unsigned i = 0; i < nr; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      uint32_t v = (seed >> 8) % max;
+      memcpy(&data[i * index_size], &v, index_size);
+   }
+   return data;
+}
+
+static void
+report(const char *name, int64_t elapsed)
+{
+   printf("  %-36s %8.1f Mindices/s\n", name,
+          (double)nr * iterations * 1000.0 / elapsed);
+}
+
+static void
+time_translator(const char *name, enum mesa_prim hw_prim, enum mesa_prim prim,
+                unsigned index_size, unsigned prim_restart,
+                const std::vector<uint8_t> &in)
+{
+   enum mesa_prim out_prim;
+   unsigned out_index_size, out_nr;
+   u_translate_func translate;
+
+   u_index_translator(1 << hw_prim, prim, index_size, nr, PV_FIRST, PV_FIRST,
+                      prim_restart, &out_prim, &out_index_size, &out_nr,
+                      &translate);
+
+   std::vector<uint8_t> out(out_nr * out_index_size);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++)
+      translate(in.data(), 0, nr, out_nr, ~0u, out.data());
+   report(name, os_time_get_nano() - start);
+}
+
+/* The loop util_prim_restart_convert_to_direct() used before. */
+template<typename T>
+static unsigned
+scalar_find_restart(const uint8_t *in, unsigned restart)
+{
+   const T *indices = (const T *)in;
+   unsigned j;
+
+   for (j = 0; j < nr && indices[j] != restart; j++)
+      ;
+   return j;
+}
+
+int
+main(int argc, char **argv)
+{
+   /* Widening 1-byte triangles: the memcpy translator uses the vector
+    * loop, the generated translator runs when the hardware lacks the
+    * primitive type.
+    */
+   std::vector<uint8_t> bytes = random_indices(1, 0xff, 1);
+   printf("ubyte to ushort, %u indices:\n", nr);
+   time_translator("vector", MESA_PRIM_TRIANGLES, MESA_PRIM_TRIANGLES, 1,
+                   PR_DISABLE, bytes);
+   time_translator("generated", MESA_PRIM_POINTS, MESA_PRIM_TRIANGLES, 1,
+                   PR_DISABLE, bytes);
+
+   /* The generated quad splitter without restart is replaced by the vector
+    * one, so compare against the generated one with restart enabled. The
+    * data contains no restart index, so both produce the same triangles.
+    */
+   for (unsigned index_size : {2, 4}) {
+      std::vector<uint8_t> indices = random_indices(index_size, 0xfffe, 5);
+
+      printf("quads to triangles, %u-byte, %u indices:\n", index_size, nr);
+      time_translator("vector", MESA_PRIM_TRIANGLES, MESA_PRIM_QUADS,
+                      index_size, PR_DISABLE, indices);
+      time_translator("generated (restart enabled)", MESA_PRIM_TRIANGLES,
+                      MESA_PRIM_QUADS, index_size, PR_ENABLE, indices);
+   }
+
+   for (unsigned index_size : {1, 2, 4}) {
+      /* Volatile, so the scalar scans are not hoisted out of the loop. */
+      volatile unsigned restart = index_size == 1 ? 0xff : 0xffff;
+      std::vector<uint8_t> indices = random_indices(index_size, restart, 7);
+      volatile unsigned found = 0;
+      int64_t start;
+
+      printf("restart scan, %u-byte, %u indices:\n", index_size, nr);
+
+      start = os_time_get_nano();
+      for (unsigned i = 0; i < iterations; i++)
+         found = found + u_index_find_restart(indices.data(), index_size, nr,
+                                              restart);
+      report("vector", os_time_get_nano() - start);
+
+      start = os_time_get_nano();
+      for (unsigned i = 0; i < iterations; i++) {
+         if (index_size == 1)
+            found = found + scalar_find_restart<uint8_t>(indices.data(), restart);
+         else if (index_size == 2)
+            found = found + scalar_find_restart<uint16_t>(indices.data(), restart);
+         else
+            found = found + scalar_find_restart<uint32_t>(indices.data(), restart);
+      }
+      report("scalar", os_time_get_nano() - start);
+   }
+   return 0;
+}
@@ -0,0 +1,378 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * Vectorized versions of the index operations that dominate primconvert
+ * and primitive restart emulation with large index buffers: widening
+ * 1-byte indices, splitting quads into triangles and scanning for the
+ * restart index.
+ *
+ * SSE2 and NEON are part of the x86-64 and aarch64 baselines, so no
+ * runtime CPU check is needed.  These loops are bound by memory bandwidth;
+ * wider vectors do not make them measurably faster.  Other architectures
+ * and the tails of the arrays use the scalar loops.
+ */
+
+#include "util/detect.h"
+#include "util/u_memory.h"
+#include "u_indices.h"
+
+#if DETECT_ARCH_SSE
+#include "util/u_sse.h"
+#elif DETECT_ARCH_AARCH64
+#include <arm_neon.h>
+#endif
+
+
+/* Find the restart index */
+
+static unsigned
+find_restart_ubyte(const uint8_t *in, unsigned nr, uint8_t restart)
+{
+   unsigned i = 0;
+
+#if DETECT_ARCH_SSE
+   const __m128i r = _mm_set1_epi8((char)restart);
+   for (; i + 16 <= nr; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, r)))
+         break;
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint8x16_t r = vdupq_n_u8(restart);
+   for (; i + 16 <= nr; i += 16) {
+      if (vmaxvq_u8(vceqq_u8(vld1q_u8(in + i), r)))
+         break;
+   }
+#endif
+
+   /* The block with the restart index, if any, is searched here. */
+   for (; i < nr; i++) {
+      if (in[i] == restart)
+         return i;
+   }
+   return nr;
+}
+
+static unsigned
+find_restart_ushort(const uint16_t *in, unsigned nr, uint16_t restart)
+{
+   unsigned i = 0;
+
+#if DETECT_ARCH_SSE
+   const __m128i r = _mm_set1_epi16((short)restart);
+   for (; i + 8 <= nr; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, r)))
+         break;
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint16x8_t r = vdupq_n_u16(restart);
+   for (; i + 8 <= nr; i += 8) {
+      if (vmaxvq_u16(vceqq_u16(vld1q_u16(in + i), r)))
+         break;
+   }
+#endif
+
+   for (; i < nr; i++) {
+      if (in[i] == restart)
+         return i;
+   }
+   return nr;
+}
+
+static unsigned
+find_restart_uint(const uint32_t *in, unsigned nr, uint32_t restart)
+{
+   unsigned i = 0;
+
+#if DETECT_ARCH_SSE
+   const __m128i r = _mm_set1_epi32((int)restart);
+   for (; i + 4 <= nr; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, r)))
+         break;
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint32x4_t r = vdupq_n_u32(restart);
+   for (; i + 4 <= nr; i += 4) {
+      if (vmaxvq_u32(vceqq_u32(vld1q_u32(in + i), r)))
+         break;
+   }
+#endif
+
+   for (; i < nr; i++) {
+      if (in[i] == restart)
+         return i;
+   }
+   return nr;
+}
+
+unsigned
+u_index_find_restart(const void *in, unsigned index_size, unsigned nr,
+                     unsigned restart_index)
+{
+   switch (index_size) {
+   case 1:
+      if (restart_index > UINT8_MAX)
+         return nr;
+      return find_restart_ubyte(in, nr, restart_index);
+   case 2:
+      if (restart_index > UINT16_MAX)
+         return nr;
+      return find_restart_ushort(in, nr, restart_index);
+   case 4:
+      return find_restart_uint(in, nr, restart_index);
+   default:
+      UNREACHABLE("bad index size");
+   }
+}
+
+
+/* Widen and remap the restart index */
+
+static void
+widen_ubyte(const uint8_t *in, unsigned nr, bool remap, uint8_t restart,
+            uint16_t *out)
+{
+   unsigned i = 0;
+
+#if DETECT_ARCH_SSE
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i r = _mm_set1_epi8((char)restart);
+   for (; i + 16 <= nr; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      __m128i lo = _mm_unpacklo_epi8(v, zero);
+      __m128i hi = _mm_unpackhi_epi8(v, zero);
+      if (remap) {
+         __m128i m = _mm_cmpeq_epi8(v, r);
+         lo = _mm_or_si128(lo, _mm_unpacklo_epi8(m, m));
+         hi = _mm_or_si128(hi, _mm_unpackhi_epi8(m, m));
+      }
+      _mm_storeu_si128((__m128i *)(out + i), lo);
+      _mm_storeu_si128((__m128i *)(out + i + 8), hi);
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint8x16_t r = vdupq_n_u8(restart);
+   for (; i + 16 <= nr; i += 16) {
+      uint8x16_t v = vld1q_u8(in + i);
+      uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+      uint16x8_t hi = vmovl_high_u8(v);
+      if (remap) {
+         /* Sign extension turns the 0xff lanes of the mask into 0xffff. */
+         int8x16_t m = vreinterpretq_s8_u8(vceqq_u8(v, r));
+         lo = vorrq_u16(lo, vreinterpretq_u16_s16(vmovl_s8(vget_low_s8(m))));
+         hi = vorrq_u16(hi, vreinterpretq_u16_s16(vmovl_high_s8(m)));
+      }
+      vst1q_u16(out + i, lo);
+      vst1q_u16(out + i + 8, hi);
+   }
+#endif
+
+   for (; i < nr; i++)
+      out[i] = remap && in[i] == restart ? 0xffff : in[i];
+}
+
+static void
+remap_restart_ushort(const uint16_t *in, unsigned nr, uint16_t restart,
+                     uint16_t *out)
+{
+   unsigned i = 0;
+
+   /* x | (x == restart ? ~0 : 0) replaces the restart index by ~0. */
+#if DETECT_ARCH_SSE
+   const __m128i r = _mm_set1_epi16((short)restart);
+   for (; i + 8 <= nr; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      v = _mm_or_si128(v, _mm_cmpeq_epi16(v, r));
+      _mm_storeu_si128((__m128i *)(out + i), v);
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint16x8_t r = vdupq_n_u16(restart);
+   for (; i + 8 <= nr; i += 8) {
+      uint16x8_t v = vld1q_u16(in + i);
+      vst1q_u16(out + i, vorrq_u16(v, vceqq_u16(v, r)));
+   }
+#endif
+
+   for (; i < nr; i++)
+      out[i] = in[i] == restart ? 0xffff : in[i];
+}
+
+static void
+remap_restart_uint(const uint32_t *in, unsigned nr, uint32_t restart,
+                   uint32_t *out)
+{
+   unsigned i = 0;
+
+#if DETECT_ARCH_SSE
+   const __m128i r = _mm_set1_epi32((int)restart);
+   for (; i + 4 <= nr; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      v = _mm_or_si128(v, _mm_cmpeq_epi32(v, r));
+      _mm_storeu_si128((__m128i *)(out + i), v);
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint32x4_t r = vdupq_n_u32(restart);
+   for (; i + 4 <= nr; i += 4) {
+      uint32x4_t v = vld1q_u32(in + i);
+      vst1q_u32(out + i, vorrq_u32(v, vceqq_u32(v, r)));
+   }
+#endif
+
+   for (; i < nr; i++)
+      out[i] = in[i] == restart ? 0xffffffff : in[i];
+}
+
+void
+u_index_widen_ubyte(const uint8_t *in, unsigned nr, uint16_t *out)
+{
+   widen_ubyte(in, nr, false, 0, out);
+}
+
+void
+u_index_remap_restart(const void *in, unsigned index_size, unsigned nr,
+                      unsigned restart_index, void *out)
+{
+   switch (index_size) {
+   case 1:
+      widen_ubyte(in, nr, restart_index <= UINT8_MAX, restart_index, out);
+      break;
+   case 2:
+      if (restart_index > UINT16_MAX)
+         memcpy(out, in, nr * 2);
+      else
+         remap_restart_ushort(in, nr, restart_index, out);
+      break;
+   case 4:
+      remap_restart_uint(in, nr, restart_index, out);
+      break;
+   default:
+      UNREACHABLE("bad index size");
+   }
+}
+
+
+/* Quads to triangles
+ *
+ * With the first vertex provoking, quad v0 v1 v2 v3 becomes triangles
+ * v0 v1 v2 and v0 v2 v3; with the last vertex provoking it becomes
+ * v0 v1 v3 and v1 v2 v3.  The vector loops handle two quads at a time,
+ * which produce 12 indices: the middle four are always v2 v3 of the first
+ * quad followed by v0 v1 of the second one.
+ */
+
+#if DETECT_ARCH_AARCH64
+/* vqtbl1q_u8 byte indices gathering four 16-bit or 32-bit lanes. */
+#define TBL16(a, b, c, d, e, f, g, h) { \
+   2*(a), 2*(a)+1, 2*(b), 2*(b)+1, 2*(c), 2*(c)+1, 2*(d), 2*(d)+1, \
+   2*(e), 2*(e)+1, 2*(f), 2*(f)+1, 2*(g), 2*(g)+1, 2*(h), 2*(h)+1 }
+#define TBL32(a, b, c, d) { \
+   4*(a), 4*(a)+1, 4*(a)+2, 4*(a)+3, 4*(b), 4*(b)+1, 4*(b)+2, 4*(b)+3, \
+   4*(c), 4*(c)+1, 4*(c)+2, 4*(c)+3, 4*(d), 4*(d)+1, 4*(d)+2, 4*(d)+3 }
+
+static const uint8_t quad_tbl16[PV_COUNT][2][16] = {
+   [PV_FIRST] = { TBL16(0, 1, 2, 0, 2, 3, 4, 5), TBL16(6, 4, 6, 7, 0, 0, 0, 0) },
+   [PV_LAST] = { TBL16(0, 1, 3, 1, 2, 3, 4, 5), TBL16(7, 5, 6, 7, 0, 0, 0, 0) },
+};
+
+static const uint8_t quad_tbl32[PV_COUNT][2][16] = {
+   [PV_FIRST] = { TBL32(0, 1, 2, 0), TBL32(2, 0, 2, 3) },
+   [PV_LAST] = { TBL32(0, 1, 3, 1), TBL32(3, 1, 2, 3) },
+};
+#endif
+
+#define QUAD_TO_TRIS(in, out, pv) do { \
+   if ((pv) == PV_FIRST) { \
+      (out)[0] = (in)[0]; (out)[1] = (in)[1]; (out)[2] = (in)[2]; \
+      (out)[3] = (in)[0]; (out)[4] = (in)[2]; (out)[5] = (in)[3]; \
+   } else { \
+      (out)[0] = (in)[0]; (out)[1] = (in)[1]; (out)[2] = (in)[3]; \
+      (out)[3] = (in)[1]; (out)[4] = (in)[2]; (out)[5] = (in)[3]; \
+   } \
+} while (0)
+
+static void
+quads_to_tris_ushort(const uint16_t *in, unsigned nr_quads, unsigned pv,
+                     uint16_t *out)
+{
+   unsigned q = 0;
+
+#if DETECT_ARCH_SSE
+   for (; q + 2 <= nr_quads; q += 2, in += 8, out += 12) {
+      __m128i v = _mm_loadu_si128((const __m128i *)in);
+      __m128i first, last;
+      if (pv == PV_FIRST) {
+         first = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 2, 1, 0));
+         last = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 2, 0, 2));
+      } else {
+         first = _mm_shufflelo_epi16(v, _MM_SHUFFLE(1, 3, 1, 0));
+         last = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 2, 1, 3));
+      }
+      _mm_storeu_si128((__m128i *)out,
+                       _mm_unpacklo_epi64(first, _mm_srli_si128(v, 4)));
+      _mm_storel_epi64((__m128i *)(out + 8), _mm_srli_si128(last, 8));
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint8x16_t t0 = vld1q_u8(quad_tbl16[pv][0]);
+   const uint8x16_t t1 = vld1q_u8(quad_tbl16[pv][1]);
+   for (; q + 2 <= nr_quads; q += 2, in += 8, out += 12) {
+      uint8x16_t v = vreinterpretq_u8_u16(vld1q_u16(in));
+      vst1q_u8((uint8_t *)out, vqtbl1q_u8(v, t0));
+      vst1_u8((uint8_t *)(out + 8), vget_low_u8(vqtbl1q_u8(v, t1)));
+   }
+#endif
+
+   for (; q < nr_quads; q++, in += 4, out += 6)
+      QUAD_TO_TRIS(in, out, pv);
+}
+
+static void
+quads_to_tris_uint(const uint32_t *in, unsigned nr_quads, unsigned pv,
+                   uint32_t *out)
+{
+   unsigned q = 0;
+
+#if DETECT_ARCH_SSE
+   for (; q + 2 <= nr_quads; q += 2, in += 8, out += 12) {
+      __m128i a = _mm_loadu_si128((const __m128i *)in);
+      __m128i b = _mm_loadu_si128((const __m128i *)(in + 4));
+      __m128i first, last;
+      if (pv == PV_FIRST) {
+         first = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 2, 1, 0));
+         last = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 0, 2));
+      } else {
+         first = _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 3, 1, 0));
+         last = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 1, 3));
+      }
+      _mm_storeu_si128((__m128i *)out, first);
+      _mm_storeu_si128((__m128i *)(out + 4),
+                       _mm_unpacklo_epi64(_mm_srli_si128(a, 8), b));
+      _mm_storeu_si128((__m128i *)(out + 8), last);
+   }
+#elif DETECT_ARCH_AARCH64
+   const uint8x16_t t0 = vld1q_u8(quad_tbl32[pv][0]);
+   const uint8x16_t t1 = vld1q_u8(quad_tbl32[pv][1]);
+   for (; q + 2 <= nr_quads; q += 2, in += 8, out += 12) {
+      uint32x4_t a = vld1q_u32(in);
+      uint32x4_t b = vld1q_u32(in + 4);
+      vst1q_u8((uint8_t *)out, vqtbl1q_u8(vreinterpretq_u8_u32(a), t0));
+      vst1q_u32(out + 4, vcombine_u32(vget_high_u32(a), vget_low_u32(b)));
+      vst1q_u8((uint8_t *)(out + 8), vqtbl1q_u8(vreinterpretq_u8_u32(b), t1));
+   }
+#endif
+
+   for (; q < nr_quads; q++, in += 4, out += 6)
+      QUAD_TO_TRIS(in, out, pv);
+}
+
+void
+u_index_quads_to_tris(const void *in, unsigned index_size, unsigned nr_quads,
+                      unsigned pv, void *out)
+{
+   assert(pv == PV_FIRST || pv == PV_LAST);
+
+   if (index_size == 4)
+      quads_to_tris_uint(in, nr_quads, pv, out);
+   else
+      quads_to_tris_ushort(in, nr_quads, pv, out);
+}
@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "u_indices.h"
+
+namespace {
+
+static std::vector<uint8_t>
+random_indices(unsigned nr, unsigned index_size, uint32_t max, uint32_t seed)
+{
+   std::vector<uint8_t> data(nr * index_size);
+
+   for (unsigned i = 0; i < nr; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      uint32_t v = (seed >> 8) % max;
+      memcpy(&data[i * index_size], &v, index_size);
+   }
+   return data;
+}
+
+static void
+set_index(std::vector<uint8_t> &data, unsigned index_size, unsigned i,
+          uint32_t v)
+{
+   memcpy(&data[i * index_size], &v, index_size);
+}
+
+static uint32_t
+max_index(unsigned index_size)
+{
+   return index_size == 4 ? 0xfffffffe : (1u << (8 * index_size)) - 1;
+}
+
+/* Splits quads with the scalar generated translator.  With restart enabled
+ * and no restart index in the data, it produces the same triangles.
+ */
+static std::vector<uint8_t>
+scalar_quads_to_tris(const std::vector<uint8_t> &in, unsigned index_size,
+                     unsigned nr, unsigned pv)
+{
+   enum mesa_prim out_prim;
+   unsigned out_index_size, out_nr;
+   u_translate_func translate;
+
+   u_index_translator(1 << MESA_PRIM_TRIANGLES, MESA_PRIM_QUADS, index_size,
+                      nr, pv, pv, PR_ENABLE, &out_prim, &out_index_size,
+                      &out_nr, &translate);
+
+   std::vector<uint8_t> out(out_nr * out_index_size);
+   translate(in.data(), 0, nr, out_nr, ~0u, out.data());
+   return out;
+}
+
+} /* namespace */
+
+TEST(u_indices, find_restart)
+{
+   for (unsigned index_size : {1, 2, 4}) {
+      const unsigned nr = 100;
+      const uint32_t restart = index_size == 1 ? 0xff : 0xffff;
+      std::vector<uint8_t> data = random_indices(nr, index_size, 0xff, 1);
+
+      EXPECT_EQ(u_index_find_restart(data.data(), index_size, nr, restart), nr);
+
+      for (unsigned pos = 0; pos < nr; pos++) {
+         std::vector<uint8_t> copy = data;
+         set_index(copy, index_size, pos, restart);
+         /* A later restart must not be found first. */
+         set_index(copy, index_size, nr - 1, restart);
+
+         EXPECT_EQ(u_index_find_restart(copy.data(), index_size, nr, restart),
+                   pos) << "index size " << index_size;
+         EXPECT_EQ(u_index_find_restart(copy.data(), index_size, pos, restart),
+                   pos) << "index size " << index_size;
+      }
+   }
+
+   /* A restart index that does not fit the index size never matches. */
+   std::vector<uint8_t> bytes(64, 0xff);
+   EXPECT_EQ(u_index_find_restart(bytes.data(), 1, 64, 0xffff), 64u);
+   EXPECT_EQ(u_index_find_restart(bytes.data(), 2, 32, 0xffffffff), 32u);
+}
+
+TEST(u_indices, remap_restart)
+{
+   for (unsigned index_size : {1, 2, 4}) {
+      for (uint32_t restart : {0x7u, 0xffffu}) {
+         const unsigned nr = 1003;
+         const unsigned out_size = u_index_size_convert(index_size);
+         std::vector<uint8_t> data = random_indices(nr, index_size, 16, 2);
+         std::vector<uint8_t> out(nr * out_size);
+
+         u_index_remap_restart(data.data(), index_size, nr, restart,
+                               out.data());
+
+         for (unsigned i = 0; i < nr; i++) {
+            uint32_t in = 0, got = 0;
+            memcpy(&in, &data[i * index_size], index_size);
+            memcpy(&got, &out[i * out_size], out_size);
+
+            uint32_t expected = in;
+            if (in == restart)
+               expected = out_size == 4 ? 0xffffffff : 0xffff;
+            ASSERT_EQ(got, expected) << "index size " << index_size
+                                     << " restart " << restart << " at " << i;
+         }
+      }
+   }
+}
+
+TEST(u_indices, translate_ubyte)
+{
+   const unsigned nr = 1001;
+   std::vector<uint8_t> data = random_indices(nr, 1, 256, 3);
+   enum mesa_prim out_prim;
+   unsigned out_index_size, out_nr;
+   u_translate_func translate;
+
+   EXPECT_EQ(u_index_translator(1 << MESA_PRIM_TRIANGLES, MESA_PRIM_TRIANGLES,
+                                1, nr, PV_FIRST, PV_FIRST, PR_DISABLE,
+                                &out_prim, &out_index_size, &out_nr,
+                                &translate),
+             U_TRANSLATE_MEMCPY);
+   ASSERT_EQ(out_index_size, 2u);
+
+   std::vector<uint16_t> out(out_nr);
+   translate(data.data(), 1, nr, out_nr - 1, ~0u, out.data());
+   for (unsigned i = 0; i < out_nr - 1; i++)
+      ASSERT_EQ(out[i], data[i + 1]) << "at " << i;
+}
+
+TEST(u_indices, quads_to_tris)
+{
+   for (unsigned index_size : {2, 4}) {
+      for (unsigned pv : {PV_FIRST, PV_LAST}) {
+         /* An odd number of quads exercises the scalar tail. */
+         const unsigned nr = 4 * 251;
+         std::vector<uint8_t> data =
+            random_indices(nr, index_size, max_index(index_size), 4);
+         enum mesa_prim out_prim;
+         unsigned out_index_size, out_nr;
+         u_translate_func translate;
+
+         u_index_translator(1 << MESA_PRIM_TRIANGLES, MESA_PRIM_QUADS,
+                            index_size, nr, pv, pv, PR_DISABLE, &out_prim,
+                            &out_index_size, &out_nr, &translate);
+         ASSERT_EQ(out_prim, MESA_PRIM_TRIANGLES);
+         ASSERT_EQ(out_nr, nr / 4 * 6);
+
+         std::vector<uint8_t> out(out_nr * out_index_size);
+         translate(data.data(), 0, nr, out_nr, ~0u, out.data());
+
+         EXPECT_EQ(out, scalar_quads_to_tris(data, index_size, nr, pv))
+            << "index size " << index_size << " pv " << pv;
+      }
+   }
+}
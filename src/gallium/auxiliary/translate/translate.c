@@ -42,6 +42,14 @@ struct translate *translate_create( const struct translate_key *key )
    translate = translate_sse2_create( key );
    if (translate)
       return translate;
+
+#ifdef HAVE_TRANSLATE_AVX2
+   /* Formats the SSE code generator can't handle, e.g. half floats and
+    * 10_10_10_2. */
+   translate = translate_avx2_create( key );
+   if (translate)
+      return translate;
+#endif
 #else
    (void)translate;
 #endif
@@ -0,0 +1,598 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * AVX2 vertex translation.
+ *
+ * Covers the keys translate_sse rejects because of their input formats:
+ * half floats, 10_10_10_2 and other non byte-aligned packed formats, and
+ * any mix of those with 8/16-bit normalized or scaled and 32-bit float
+ * inputs. Every element is either copied unchanged or converted to a
+ * 32-bit float output format.
+ *
+ * Vertices are processed 8 at a time: each element of the 8 vertices is
+ * loaded into a register, transposed so that every dword of the element
+ * sits in one 256-bit register, converted channel by channel and
+ * transposed back for the store.
+ *
+ * This file is built with -mavx2 -mf16c; translate_avx2_create() checks
+ * the CPU before handing out a translate object.
+ */
+
+#include <immintrin.h>
+
+#include "util/u_cpu_detect.h"
+#include "util/u_memory.h"
+#include "util/format/u_format.h"
+#include "pipe/p_state.h"
+#include "translate.h"
+
+
+#define AVX2_BLOCK 8
+
+enum avx2_attrib_kind {
+   AVX2_ATTRIB_COPY,
+   AVX2_ATTRIB_CONVERT,
+   AVX2_ATTRIB_INSTANCE_ID,
+};
+
+enum avx2_channel_kind {
+   AVX2_CHANNEL_ZERO,
+   AVX2_CHANNEL_ONE,
+   AVX2_CHANNEL_FLOAT32,
+   AVX2_CHANNEL_FLOAT16,
+   AVX2_CHANNEL_UNSIGNED,
+   AVX2_CHANNEL_SIGNED,
+};
+
+/* Where one output channel comes from, after applying the format swizzle. */
+struct avx2_channel {
+   enum avx2_channel_kind kind;
+   unsigned dword;        /* dword of the input element holding the bits */
+   unsigned shift;        /* bit offset inside that dword */
+   unsigned size;         /* bits */
+   float scale;           /* 1.0f unless normalized */
+   bool snorm;            /* clamp to -1.0f after scaling */
+};
+
+struct translate_avx2 {
+   struct translate translate;
+
+   struct {
+      enum avx2_attrib_kind kind;
+      unsigned buffer;
+      unsigned input_offset;
+      unsigned instance_divisor;
+      unsigned output_offset;
+
+      unsigned input_size;       /* bytes read per vertex */
+      unsigned output_channels;  /* floats written per vertex */
+      bool instance_id_float;    /* instance id as float or raw uint */
+      struct avx2_channel channel[4];
+
+      const uint8_t *input_ptr;
+      unsigned input_stride;
+      unsigned max_index;
+   } attrib[TRANSLATE_MAX_ATTRIBS];
+
+   unsigned nr_attrib;
+};
+
+
+static struct translate_avx2 *
+translate_avx2(struct translate *translate)
+{
+   return (struct translate_avx2 *)translate;
+}
+
+
+/**
+ * Load one input element into the low bytes of a register without reading
+ * past its end.
+ */
+static ALWAYS_INLINE __m128i
+load_element(const uint8_t *src, unsigned size)
+{
+   uint32_t lo, hi = 0;
+
+   switch (size) {
+   case 16:
+      return _mm_loadu_si128((const __m128i *)src);
+   case 12:
+      memcpy(&hi, src + 8, 4);
+      return _mm_insert_epi32(_mm_loadl_epi64((const __m128i *)src), hi, 2);
+   case 8:
+      return _mm_loadl_epi64((const __m128i *)src);
+   case 6:
+      memcpy(&lo, src, 4);
+      memcpy(&hi, src + 4, 2);
+      return _mm_insert_epi16(_mm_cvtsi32_si128(lo), hi, 2);
+   case 4:
+      memcpy(&lo, src, 4);
+      return _mm_cvtsi32_si128(lo);
+   case 3:
+      lo = src[0] | src[1] << 8 | src[2] << 16;
+      return _mm_cvtsi32_si128(lo);
+   case 2:
+      lo = src[0] | src[1] << 8;
+      return _mm_cvtsi32_si128(lo);
+   case 1:
+      return _mm_cvtsi32_si128(src[0]);
+   default: {
+      uint32_t tmp[4] = {0};
+      memcpy(tmp, src, size);
+      return _mm_loadu_si128((const __m128i *)tmp);
+   }
+   }
+}
+
+
+/**
+ * Load the element of 8 vertices and turn it into one register per dword,
+ * vertices 0-3 in the low lane and 4-7 in the high lane. Only the first
+ * 'count' pointers are valid.
+ */
+static ALWAYS_INLINE void
+load_transpose(const uint8_t *const *src, unsigned count, unsigned size,
+               __m256i dwords[4])
+{
+   __m128i r[AVX2_BLOCK];
+   __m256i a[4];
+
+   /* Dispatch once per block so that each loop loads a constant size. */
+#define LOAD_ELEMENTS(SIZE)                                   \
+   for (unsigned i = 0; i < AVX2_BLOCK; i++)                  \
+      r[i] = i < count ? load_element(src[i], SIZE)           \
+                       : _mm_setzero_si128();
+
+   switch (size) {
+   case 2: LOAD_ELEMENTS(2); break;
+   case 4: LOAD_ELEMENTS(4); break;
+   case 6: LOAD_ELEMENTS(6); break;
+   case 8: LOAD_ELEMENTS(8); break;
+   case 12: LOAD_ELEMENTS(12); break;
+   case 16: LOAD_ELEMENTS(16); break;
+   default: LOAD_ELEMENTS(size); break;
+   }
+#undef LOAD_ELEMENTS
+
+   for (unsigned i = 0; i < 4; i++)
+      a[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(r[i]), r[i + 4], 1);
+
+   __m256i t0 = _mm256_unpacklo_epi32(a[0], a[1]);
+   __m256i t1 = _mm256_unpacklo_epi32(a[2], a[3]);
+   __m256i t2 = _mm256_unpackhi_epi32(a[0], a[1]);
+   __m256i t3 = _mm256_unpackhi_epi32(a[2], a[3]);
+
+   dwords[0] = _mm256_unpacklo_epi64(t0, t1);
+   dwords[1] = _mm256_unpackhi_epi64(t0, t1);
+   dwords[2] = _mm256_unpacklo_epi64(t2, t3);
+   dwords[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+
+static ALWAYS_INLINE __m256
+convert_channel(const struct avx2_channel *ch, const __m256i dwords[4])
+{
+   __m256i w = dwords[ch->dword];
+   __m256 f;
+
+   switch (ch->kind) {
+   case AVX2_CHANNEL_ZERO:
+      return _mm256_setzero_ps();
+   case AVX2_CHANNEL_ONE:
+      return _mm256_set1_ps(1.0f);
+   case AVX2_CHANNEL_FLOAT32:
+      return _mm256_castsi256_ps(w);
+   case AVX2_CHANNEL_FLOAT16: {
+      w = ch->shift ? _mm256_srli_epi32(w, 16)
+                    : _mm256_and_si256(w, _mm256_set1_epi32(0xffff));
+      /* Narrow to 16 bits and gather the eight halves in the low lane. */
+      w = _mm256_packus_epi32(w, w);
+      w = _mm256_permute4x64_epi64(w, _MM_SHUFFLE(3, 1, 2, 0));
+      return _mm256_cvtph_ps(_mm256_castsi256_si128(w));
+   }
+   case AVX2_CHANNEL_UNSIGNED:
+      w = _mm256_srl_epi32(w, _mm_cvtsi32_si128(ch->shift));
+      w = _mm256_and_si256(w, _mm256_set1_epi32((1u << ch->size) - 1));
+      f = _mm256_cvtepi32_ps(w);
+      break;
+   case AVX2_CHANNEL_SIGNED:
+      w = _mm256_sll_epi32(w, _mm_cvtsi32_si128(32 - ch->shift - ch->size));
+      w = _mm256_sra_epi32(w, _mm_cvtsi32_si128(32 - ch->size));
+      f = _mm256_cvtepi32_ps(w);
+      break;
+   default:
+      UNREACHABLE("bad channel kind");
+   }
+
+   if (ch->scale != 1.0f)
+      f = _mm256_mul_ps(f, _mm256_set1_ps(ch->scale));
+   if (ch->snorm)
+      f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+   return f;
+}
+
+
+static ALWAYS_INLINE void
+store_vertex(uint8_t *dst, __m128 v, unsigned nr_channels)
+{
+   switch (nr_channels) {
+   case 4:
+      _mm_storeu_ps((float *)dst, v);
+      break;
+   case 3:
+      _mm_storel_pi((__m64 *)dst, v);
+      _mm_store_ss((float *)(dst + 8), _mm_movehl_ps(v, v));
+      break;
+   case 2:
+      _mm_storel_pi((__m64 *)dst, v);
+      break;
+   default:
+      _mm_store_ss((float *)dst, v);
+      break;
+   }
+}
+
+
+/**
+ * Convert the element of 'count' vertices and write them to 'dst'.
+ */
+static ALWAYS_INLINE void
+convert_block(const struct avx2_channel *channels, unsigned nr_channels,
+              const uint8_t *const *src, unsigned size, unsigned count,
+              uint8_t *dst, unsigned stride)
+{
+   __m256i dwords[4];
+   __m256 c[4];
+
+   load_transpose(src, count, size, dwords);
+
+   for (unsigned i = 0; i < 4; i++)
+      c[i] = i < nr_channels ? convert_channel(&channels[i], dwords)
+                             : _mm256_setzero_ps();
+
+   /* Back to one vertex per 128-bit half. */
+   __m256 t0 = _mm256_unpacklo_ps(c[0], c[1]);
+   __m256 t1 = _mm256_unpacklo_ps(c[2], c[3]);
+   __m256 t2 = _mm256_unpackhi_ps(c[0], c[1]);
+   __m256 t3 = _mm256_unpackhi_ps(c[2], c[3]);
+   __m256 v[4] = {
+      _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)),
+      _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+   };
+
+#define STORE_VERTICES(NR_CHANNELS)                                     \
+   for (unsigned i = 0; i < count; i++) {                               \
+      __m128 vert = i < 4 ? _mm256_castps256_ps128(v[i])                \
+                          : _mm256_extractf128_ps(v[i - 4], 1);         \
+      store_vertex(dst + i * stride, vert, NR_CHANNELS);                \
+   }
+
+   switch (nr_channels) {
+   case 4: STORE_VERTICES(4); break;
+   case 3: STORE_VERTICES(3); break;
+   case 2: STORE_VERTICES(2); break;
+   default: STORE_VERTICES(1); break;
+   }
+#undef STORE_VERTICES
+}
+
+
+static ALWAYS_INLINE void
+avx2_run_block(struct translate_avx2 *ta,
+               const unsigned *elts, unsigned count,
+               unsigned start_instance, unsigned instance_id,
+               uint8_t *vert, unsigned index_size)
+{
+   const unsigned stride = ta->translate.key.output_stride;
+
+   for (unsigned attr = 0; attr < ta->nr_attrib; attr++) {
+      uint8_t *dst = vert + ta->attrib[attr].output_offset;
+      const uint8_t *src[AVX2_BLOCK];
+
+      if (ta->attrib[attr].kind == AVX2_ATTRIB_INSTANCE_ID) {
+         for (unsigned i = 0; i < count; i++) {
+            if (ta->attrib[attr].instance_id_float)
+               *(float *)(dst + i * stride) = (float)instance_id;
+            else
+               *(uint32_t *)(dst + i * stride) = instance_id;
+         }
+         continue;
+      }
+
+      if (ta->attrib[attr].instance_divisor) {
+         unsigned index = start_instance +
+                          instance_id / ta->attrib[attr].instance_divisor;
+         const uint8_t *ptr = ta->attrib[attr].input_ptr +
+                              (ptrdiff_t)ta->attrib[attr].input_stride * index;
+
+         for (unsigned i = 0; i < count; i++)
+            src[i] = ptr;
+      } else {
+         for (unsigned i = 0; i < count; i++) {
+            unsigned index = elts[i];
+
+            /* clamp to avoid going out of bounds */
+            if (index_size > 0)
+               index = MIN2(index, ta->attrib[attr].max_index);
+
+            src[i] = ta->attrib[attr].input_ptr +
+                     (ptrdiff_t)ta->attrib[attr].input_stride * index;
+         }
+      }
+
+      const unsigned size = ta->attrib[attr].input_size;
+
+      if (ta->attrib[attr].kind == AVX2_ATTRIB_COPY) {
+         for (unsigned i = 0; i < count; i++)
+            memcpy(dst + i * stride, src[i], size);
+         continue;
+      }
+
+      convert_block(ta->attrib[attr].channel,
+                    ta->attrib[attr].output_channels,
+                    src, size, count, dst, stride);
+   }
+}
+
+
+static ALWAYS_INLINE void
+avx2_run_common(struct translate_avx2 *ta,
+                const void *elts, unsigned index_size,
+                unsigned start, unsigned count,
+                unsigned start_instance, unsigned instance_id,
+                void *output_buffer)
+{
+   const unsigned stride = ta->translate.key.output_stride;
+   uint8_t *vert = output_buffer;
+
+   for (unsigned i = 0; i < count; i += AVX2_BLOCK) {
+      const unsigned n = MIN2(count - i, AVX2_BLOCK);
+      unsigned indices[AVX2_BLOCK];
+
+      for (unsigned j = 0; j < n; j++) {
+         switch (index_size) {
+         case 4: indices[j] = ((const unsigned *)elts)[i + j]; break;
+         case 2: indices[j] = ((const uint16_t *)elts)[i + j]; break;
+         case 1: indices[j] = ((const uint8_t *)elts)[i + j]; break;
+         default: indices[j] = start + i + j; break;
+         }
+      }
+
+      avx2_run_block(ta, indices, n, start_instance, instance_id,
+                     vert, index_size);
+      vert += n * stride;
+   }
+}
+
+
+static void UTIL_CDECL
+avx2_run_elts(struct translate *translate,
+              const unsigned *elts,
+              unsigned count,
+              unsigned start_instance,
+              unsigned instance_id,
+              void *output_buffer)
+{
+   avx2_run_common(translate_avx2(translate), elts, 4, 0, count,
+                   start_instance, instance_id, output_buffer);
+}
+
+static void UTIL_CDECL
+avx2_run_elts16(struct translate *translate,
+                const uint16_t *elts,
+                unsigned count,
+                unsigned start_instance,
+                unsigned instance_id,
+                void *output_buffer)
+{
+   avx2_run_common(translate_avx2(translate), elts, 2, 0, count,
+                   start_instance, instance_id, output_buffer);
+}
+
+static void UTIL_CDECL
+avx2_run_elts8(struct translate *translate,
+               const uint8_t *elts,
+               unsigned count,
+               unsigned start_instance,
+               unsigned instance_id,
+               void *output_buffer)
+{
+   avx2_run_common(translate_avx2(translate), elts, 1, 0, count,
+                   start_instance, instance_id, output_buffer);
+}
+
+static void UTIL_CDECL
+avx2_run(struct translate *translate,
+         unsigned start,
+         unsigned count,
+         unsigned start_instance,
+         unsigned instance_id,
+         void *output_buffer)
+{
+   avx2_run_common(translate_avx2(translate), NULL, 0, start, count,
+                   start_instance, instance_id, output_buffer);
+}
+
+
+static void
+avx2_set_buffer(struct translate *translate,
+                unsigned buf,
+                const void *ptr,
+                unsigned stride,
+                unsigned max_index)
+{
+   struct translate_avx2 *ta = translate_avx2(translate);
+
+   for (unsigned i = 0; i < ta->nr_attrib; i++) {
+      if (ta->attrib[i].buffer == buf) {
+         ta->attrib[i].input_ptr = ((const uint8_t *)ptr +
+                                    ta->attrib[i].input_offset);
+         ta->attrib[i].input_stride = stride;
+         ta->attrib[i].max_index = max_index;
+      }
+   }
+}
+
+
+static void
+avx2_release(struct translate *translate)
+{
+   FREE(translate);
+}
+
+
+static unsigned
+float_output_channels(enum pipe_format format)
+{
+   switch (format) {
+   case PIPE_FORMAT_R32_FLOAT: return 1;
+   case PIPE_FORMAT_R32G32_FLOAT: return 2;
+   case PIPE_FORMAT_R32G32B32_FLOAT: return 3;
+   case PIPE_FORMAT_R32G32B32A32_FLOAT: return 4;
+   default: return 0;
+   }
+}
+
+
+/**
+ * Describe where output channel 'swz' comes from in the input element, or
+ * return false if this backend can't convert it.
+ */
+static bool
+setup_channel(const struct util_format_description *desc, unsigned swz,
+              struct avx2_channel *ch)
+{
+   memset(ch, 0, sizeof(*ch));
+   ch->scale = 1.0f;
+
+   if (swz == PIPE_SWIZZLE_0 || swz == PIPE_SWIZZLE_NONE) {
+      ch->kind = AVX2_CHANNEL_ZERO;
+      return true;
+   }
+   if (swz == PIPE_SWIZZLE_1) {
+      ch->kind = AVX2_CHANNEL_ONE;
+      return true;
+   }
+
+   const struct util_format_channel_description *c = &desc->channel[swz];
+
+   if (c->pure_integer)
+      return false;
+
+   ch->dword = c->shift / 32;
+   ch->shift = c->shift % 32;
+   ch->size = c->size;
+
+   if (ch->shift + ch->size > 32)
+      return false;
+
+   switch (c->type) {
+   case UTIL_FORMAT_TYPE_FLOAT:
+      if (c->size == 32)
+         ch->kind = AVX2_CHANNEL_FLOAT32;
+      else if (c->size == 16)
+         ch->kind = AVX2_CHANNEL_FLOAT16;
+      else
+         return false;
+      return true;
+   case UTIL_FORMAT_TYPE_UNSIGNED:
+      /* 32-bit integers don't convert exactly with cvtepi32_ps. */
+      if (c->size > 16)
+         return false;
+      ch->kind = AVX2_CHANNEL_UNSIGNED;
+      if (c->normalized)
+         ch->scale = 1.0f / ((1u << c->size) - 1);
+      return true;
+   case UTIL_FORMAT_TYPE_SIGNED:
+      if (c->size > 16)
+         return false;
+      ch->kind = AVX2_CHANNEL_SIGNED;
+      if (c->normalized) {
+         ch->scale = 1.0f / ((1u << (c->size - 1)) - 1);
+         ch->snorm = true;
+      }
+      return true;
+   default:
+      return false;
+   }
+}
+
+
+struct translate *
+translate_avx2_create(const struct translate_key *key)
+{
+   struct translate_avx2 *ta;
+
+   if (!util_get_cpu_caps()->has_avx2 || !util_get_cpu_caps()->has_f16c)
+      return NULL;
+
+   ta = CALLOC_STRUCT(translate_avx2);
+   if (!ta)
+      return NULL;
+
+   assert(key->nr_elements <= TRANSLATE_MAX_ATTRIBS);
+
+   ta->translate.key = *key;
+   ta->translate.release = avx2_release;
+   ta->translate.set_buffer = avx2_set_buffer;
+   ta->translate.run_elts = avx2_run_elts;
+   ta->translate.run_elts16 = avx2_run_elts16;
+   ta->translate.run_elts8 = avx2_run_elts8;
+   ta->translate.run = avx2_run;
+
+   for (unsigned i = 0; i < key->nr_elements; i++) {
+      const struct translate_element *element = &key->element[i];
+
+      ta->attrib[i].buffer = element->input_buffer;
+      ta->attrib[i].input_offset = element->input_offset;
+      ta->attrib[i].instance_divisor = element->instance_divisor;
+      ta->attrib[i].output_offset = element->output_offset;
+
+      if (element->type == TRANSLATE_ELEMENT_INSTANCE_ID) {
+         ta->attrib[i].kind = AVX2_ATTRIB_INSTANCE_ID;
+         if (element->output_format == PIPE_FORMAT_R32_FLOAT)
+            ta->attrib[i].instance_id_float = true;
+         else if (element->output_format != PIPE_FORMAT_R32_USCALED &&
+                  element->output_format != PIPE_FORMAT_R32_SSCALED)
+            goto fail;
+         continue;
+      }
+
+      const struct util_format_description *desc =
+         util_format_description(element->input_format);
+
+      if (!desc || desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+          desc->block.width != 1 || desc->block.height != 1 ||
+          (desc->block.bits & 7) || desc->block.bits > 128)
+         goto fail;
+
+      ta->attrib[i].input_size = desc->block.bits / 8;
+
+      if (element->input_format == element->output_format) {
+         ta->attrib[i].kind = AVX2_ATTRIB_COPY;
+         continue;
+      }
+
+      unsigned nr_channels = float_output_channels(element->output_format);
+      if (!nr_channels || desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB)
+         goto fail;
+
+      ta->attrib[i].kind = AVX2_ATTRIB_CONVERT;
+      ta->attrib[i].output_channels = nr_channels;
+      for (unsigned c = 0; c < nr_channels; c++) {
+         if (!setup_channel(desc, desc->swizzle[c], &ta->attrib[i].channel[c]))
+            goto fail;
+      }
+   }
+
+   ta->nr_attrib = key->nr_elements;
+
+   return &ta->translate;
+
+fail:
+   FREE(ta);
+   return NULL;
+}
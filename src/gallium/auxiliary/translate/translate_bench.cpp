@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: MIT */
+
+/* Measures the vertex throughput of the translate backends. Not run as part
+ * of the test suite.
+ *
+ * translate_create() only falls back to the AVX2 backend for keys the SSE
+ * code generator rejects, so each layout reports which backends accept it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "translate.h"
+#include "util/detect.h"
+#include "util/os_time.h"
+#include "util/format/u_format.h"
+
+struct layout {
+   const char *name;
+   unsigned input_stride;
+   struct translate_key key;
+};
+
+static void
+add_element(struct translate_key *key, enum pipe_format input_format,
+            enum pipe_format output_format, unsigned input_offset)
+{
+   struct translate_element *e = &key->element[key->nr_elements++];
+
+   e->type = TRANSLATE_ELEMENT_NORMAL;
+   e->input_format = input_format;
+   e->output_format = output_format;
+   e->input_offset = input_offset;
+   e->output_offset = key->output_stride;
+   key->output_stride += util_format_get_blocksize(output_format);
+}
+
+static void
+run_backend(const char *backend, struct translate *t,
+            const struct layout *l, const std::vector<uint8_t> &input,
+            unsigned count)
+{
+   const unsigned iterations = 32;
+
+   if (!t) {
+      printf("  %-8s n/a\n", backend);
+      return;
+   }
+
+   std::vector<uint8_t> output(count * l->key.output_stride);
+   t->set_buffer(t, 0, input.data(), l->input_stride, count - 1);
+
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++)
+      t->run(t, 0, count, 0, 0, output.data());
+   int64_t elapsed = os_time_get_nano() - start;
+
+   printf("  %-8s %8.1f Mverts/s\n", backend,
+          (double)count * iterations * 1000.0 / elapsed);
+   t->release(t);
+}
+
+int
+main(int argc, char **argv)
+{
+   const unsigned count = 1 << 16;
+   struct layout layouts[2];
+
+   memset(layouts, 0, sizeof(layouts));
+
+   /* Packed position, normal and texcoord. The SSE backend rejects half
+    * floats and 10_10_10_2.
+    */
+   layouts[0].name = "half float, 10_10_10_2 snorm, 16-bit unorm";
+   layouts[0].input_stride = 16;
+   add_element(&layouts[0].key, PIPE_FORMAT_R16G16B16A16_FLOAT,
+               PIPE_FORMAT_R32G32B32A32_FLOAT, 0);
+   add_element(&layouts[0].key, PIPE_FORMAT_R10G10B10A2_SNORM,
+               PIPE_FORMAT_R32G32B32_FLOAT, 8);
+   add_element(&layouts[0].key, PIPE_FORMAT_R16G16_UNORM,
+               PIPE_FORMAT_R32G32_FLOAT, 12);
+
+   /* Float position, 8-bit color and float texcoord copied as is, which
+    * the SSE backend handles.
+    */
+   layouts[1].name = "float, 8-bit unorm, float copies";
+   layouts[1].input_stride = 24;
+   add_element(&layouts[1].key, PIPE_FORMAT_R32G32B32_FLOAT,
+               PIPE_FORMAT_R32G32B32_FLOAT, 0);
+   add_element(&layouts[1].key, PIPE_FORMAT_R8G8B8A8_UNORM,
+               PIPE_FORMAT_R8G8B8A8_UNORM, 12);
+   add_element(&layouts[1].key, PIPE_FORMAT_R32G32_FLOAT,
+               PIPE_FORMAT_R32G32_FLOAT, 16);
+
+   for (const struct layout &l : layouts) {
+      std::vector<uint8_t> input(count * l.input_stride);
+      uint32_t seed = 3;
+
+      /* Random bits, but no half float or float NaN/Inf exponents. */
+      for (size_t i = 0; i < input.size(); i++) {
+         seed = seed * 1664525u + 1013904223u;
+         input[i] = (seed >> 24) & 0x3f;
+      }
+
+      printf("%s, %u verts:\n", l.name, count);
+      run_backend("generic", translate_generic_create(&l.key), &l, input, count);
+#if DETECT_ARCH_X86 || DETECT_ARCH_X86_64
+      run_backend("sse2", translate_sse2_create(&l.key), &l, input, count);
+#endif
+#ifdef HAVE_TRANSLATE_AVX2
+      run_backend("avx2", translate_avx2_create(&l.key), &l, input, count);
+#endif
+   }
+   return 0;
+}
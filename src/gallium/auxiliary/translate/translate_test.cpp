@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <vector>
+
+#include "translate.h"
+#include "util/u_cpu_detect.h"
+#include "util/format/u_format.h"
+
+#ifdef HAVE_TRANSLATE_AVX2
+
+namespace {
+
+const unsigned num_verts = 1000;
+const unsigned input_stride = 32;
+
+struct translate_pair {
+   struct translate *generic;
+   struct translate *avx2;
+
+   ~translate_pair()
+   {
+      if (generic)
+         generic->release(generic);
+      if (avx2)
+         avx2->release(avx2);
+   }
+};
+
+static bool
+setup(translate_pair *p, const struct translate_key *key)
+{
+   if (!util_get_cpu_caps()->has_avx2 || !util_get_cpu_caps()->has_f16c)
+      return false;
+
+   p->generic = translate_generic_create(key);
+   p->avx2 = translate_avx2_create(key);
+   return p->generic && p->avx2;
+}
+
+static std::vector<uint8_t>
+random_input(unsigned size, uint32_t seed)
+{
+   std::vector<uint8_t> data(size);
+
+   for (unsigned i = 0; i < size; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      data[i] = seed >> 24;
+   }
+   return data;
+}
+
+static void
+expect_same_output(const std::vector<uint8_t> &a,
+                   const std::vector<uint8_t> &b,
+                   enum pipe_format input_format)
+{
+   ASSERT_EQ(a.size(), b.size());
+
+   for (unsigned i = 0; i < a.size(); i += 4) {
+      float fa, fb;
+      memcpy(&fa, &a[i], 4);
+      memcpy(&fb, &b[i], 4);
+
+      /* Half float NaNs may be quieted differently. */
+      if (isnan(fa) && isnan(fb))
+         continue;
+
+      EXPECT_EQ(memcmp(&fa, &fb, 4), 0)
+         << util_format_name(input_format) << " at byte " << i
+         << ": " << fa << " vs " << fb;
+   }
+}
+
+static void
+compare_key(const struct translate_key *key, enum pipe_format input_format)
+{
+   translate_pair p = {};
+
+   ASSERT_TRUE(setup(&p, key) || !util_get_cpu_caps()->has_avx2);
+   if (!p.avx2)
+      GTEST_SKIP() << "AVX2 backend not available";
+
+   std::vector<uint8_t> input = random_input(num_verts * input_stride, 7);
+   std::vector<uint16_t> elts(num_verts);
+   for (unsigned i = 0; i < num_verts; i++)
+      elts[i] = (i * 37) % (num_verts + 10); /* some out of range */
+
+   for (struct translate *t : {p.generic, p.avx2}) {
+      t->set_buffer(t, 0, input.data(), input_stride, num_verts - 1);
+      t->set_buffer(t, 1, input.data(), input_stride, num_verts - 1);
+   }
+
+   const unsigned out_size = (num_verts + 3) * key->output_stride;
+   std::vector<uint8_t> out_generic(out_size, 0), out_avx2(out_size, 0);
+
+   /* Odd start and count to exercise the partial last block. */
+   p.generic->run(p.generic, 3, num_verts - 5, 0, 2, out_generic.data());
+   p.avx2->run(p.avx2, 3, num_verts - 5, 0, 2, out_avx2.data());
+   expect_same_output(out_generic, out_avx2, input_format);
+
+   p.generic->run_elts16(p.generic, elts.data(), num_verts, 1, 3,
+                         out_generic.data());
+   p.avx2->run_elts16(p.avx2, elts.data(), num_verts, 1, 3, out_avx2.data());
+   expect_same_output(out_generic, out_avx2, input_format);
+}
+
+static struct translate_key
+make_key(enum pipe_format input_format, enum pipe_format output_format)
+{
+   struct translate_key key;
+   memset(&key, 0, sizeof(key));
+
+   const unsigned out_size = util_format_get_blocksize(output_format);
+
+   /* A per-vertex element followed by an instanced one. */
+   key.nr_elements = 2;
+   key.element[0].type = TRANSLATE_ELEMENT_NORMAL;
+   key.element[0].input_format = input_format;
+   key.element[0].output_format = output_format;
+   key.element[0].input_buffer = 0;
+   key.element[0].input_offset = 4;
+   key.element[0].output_offset = 0;
+
+   key.element[1] = key.element[0];
+   key.element[1].input_buffer = 1;
+   key.element[1].input_offset = 0;
+   key.element[1].instance_divisor = 2;
+   key.element[1].output_offset = out_size;
+
+   key.output_stride = 2 * out_size + 4;
+   return key;
+}
+
+} /* namespace */
+
+static const enum pipe_format input_formats[] = {
+   PIPE_FORMAT_R16_FLOAT,
+   PIPE_FORMAT_R16G16_FLOAT,
+   PIPE_FORMAT_R16G16B16_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R10G10B10A2_UNORM,
+   PIPE_FORMAT_R10G10B10A2_SNORM,
+   PIPE_FORMAT_R10G10B10A2_USCALED,
+   PIPE_FORMAT_R10G10B10A2_SSCALED,
+   PIPE_FORMAT_B10G10R10A2_UNORM,
+   PIPE_FORMAT_B10G10R10A2_SNORM,
+   PIPE_FORMAT_R16G16_UNORM,
+   PIPE_FORMAT_R16G16B16_SNORM,
+   PIPE_FORMAT_R16G16B16A16_SSCALED,
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_R8G8_SNORM,
+   PIPE_FORMAT_R8G8B8_USCALED,
+   PIPE_FORMAT_R32G32B32_FLOAT,
+};
+
+static const enum pipe_format output_formats[] = {
+   PIPE_FORMAT_R32_FLOAT,
+   PIPE_FORMAT_R32G32_FLOAT,
+   PIPE_FORMAT_R32G32B32_FLOAT,
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+};
+
+TEST(translate_avx2, matches_generic)
+{
+   for (enum pipe_format in : input_formats) {
+      for (enum pipe_format out : output_formats) {
+         struct translate_key key = make_key(in, out);
+         compare_key(&key, in);
+      }
+   }
+}
+
+TEST(translate_avx2, rejects_unsupported)
+{
+   if (!util_get_cpu_caps()->has_avx2 || !util_get_cpu_caps()->has_f16c)
+      GTEST_SKIP() << "no AVX2";
+
+   /* Integer outputs stay on the generic path. */
+   struct translate_key key =
+      make_key(PIPE_FORMAT_R16G16_UNORM, PIPE_FORMAT_R16G16_SNORM);
+   EXPECT_EQ(translate_avx2_create(&key), nullptr);
+
+   key = make_key(PIPE_FORMAT_R32G32_UINT, PIPE_FORMAT_R32G32B32A32_FLOAT);
+   EXPECT_EQ(translate_avx2_create(&key), nullptr);
+}
+
+#endif /* HAVE_TRANSLATE_AVX2 */
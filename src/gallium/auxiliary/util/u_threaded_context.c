@@ -593,6 +593,29 @@ tc_batch_flush(struct threaded_context *tc, bool full_copy)
 
 }
 
+/* Adapt the batch size to how fast the driver thread consumes batches.
+ * Called when the current batch is full, before it's flushed.
+ */
+static void
+tc_update_batch_slot_limit(struct threaded_context *tc)
+{
+   unsigned next_id = (tc->next + 1) % TC_MAX_BATCHES;
+
+   if (util_queue_fence_is_signalled(&tc->batch_slots[tc->last].fence)) {
+      /* The driver thread is idle: flush sooner so that it starts working
+       * while we record the rest.
+       */
+      tc->batch_slot_limit = MAX2(tc->batch_slot_limit / 2,
+                                  TC_MIN_SLOTS_PER_BATCH);
+   } else if (!util_queue_fence_is_signalled(&tc->batch_slots[next_id].fence)) {
+      /* All batches are queued and we are about to wait for a free one:
+       * use bigger batches to reduce the per-batch overhead.
+       */
+      tc->batch_slot_limit = MIN2(tc->batch_slot_limit * 2,
+                                  TC_SLOTS_PER_BATCH - 1);
+   }
+}
+
 /* This is the function that adds variable-sized calls into the current
  * batch. It also flushes the batch if there is not enough space there.
  * All other higher-level "add" functions use it.
@@ -606,7 +629,13 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
    assert(num_slots <= TC_SLOTS_PER_BATCH - 1);
    tc_debug_check(tc);
 
-   if (unlikely(next->num_total_slots + num_slots + resv_slots > TC_SLOTS_PER_BATCH - 1)) {
+   /* The soft limit doesn't apply to empty batches, so that calls bigger
+    * than the limit still fit.
+    */
+   if (unlikely(next->num_total_slots + num_slots + resv_slots > TC_SLOTS_PER_BATCH - 1 ||
+                (next->num_total_slots &&
+                 next->num_total_slots + num_slots + resv_slots > tc->batch_slot_limit))) {
+      tc_update_batch_slot_limit(tc);
       /* copy existing renderpass info during flush */
       tc_batch_flush(tc, full_copy);
       tc->seen_fb_state = false;
@@ -1093,6 +1122,15 @@ tc_is_buffer_busy(struct threaded_context *tc, struct threaded_resource *tbuf,
    return tc->options.is_resource_busy(tc->pipe->screen, tbuf->latest, map_usage);
 }
 
+/* Called by tc's own uploaders before reusing a retired buffer. */
+static bool
+tc_upload_buffer_is_busy(void *data, struct pipe_resource *buffer)
+{
+   struct threaded_context *tc = (struct threaded_context *)data;
+
+   return tc_is_buffer_busy(tc, threaded_resource(buffer), PIPE_MAP_WRITE);
+}
+
 /**
  * allow_cpu_storage should be false for user memory and imported buffers.
  */
@@ -3987,6 +4025,8 @@ tc_draw_user_indices_single(struct pipe_context *_pipe,
    p->info.max_index = draws[0].count;
    p->index_bias = draws[0].index_bias;
    simplify_draw_info(&p->info);
+   /* The uploader may recycle the buffer once it's idle. */
+   tc_add_to_buffer_list(&tc->buffer_lists[tc->next_buf_list], buffer);
    pipe_resource_release(_pipe, releasebuf);
 }
 
@@ -4029,6 +4069,7 @@ tc_draw_user_indices_single_draw_id(struct pipe_context *_pipe,
    p->info.max_index = draws[0].count;
    p->index_bias = draws[0].index_bias;
    simplify_draw_info(&p->info);
+   tc_add_to_buffer_list(&tc->buffer_lists[tc->next_buf_list], buffer);
    pipe_resource_release(_pipe, releasebuf);
 }
 
@@ -4132,6 +4173,7 @@ tc_draw_user_indices_multi(struct pipe_context *_pipe,
       memcpy(&p->info, info, DRAW_INFO_SIZE_WITHOUT_INDEXBUF_AND_MIN_MAX_INDEX);
 
       p->info.index.resource = buffer;
+      tc_add_to_buffer_list(&tc->buffer_lists[tc->next_buf_list], buffer);
 
       p->num_draws = dr;
 
@@ -5585,6 +5627,14 @@ threaded_context_create(struct pipe_context *pipe,
    if (!tc->base.stream_uploader || !tc->base.const_uploader)
       goto fail;
 
+   if (tc->options.is_resource_busy) {
+      u_upload_enable_recycling(tc->base.stream_uploader,
+                                tc_upload_buffer_is_busy, tc);
+      if (tc->base.const_uploader != tc->base.stream_uploader)
+         u_upload_enable_recycling(tc->base.const_uploader,
+                                   tc_upload_buffer_is_busy, tc);
+   }
+
    tc->use_forced_staging_uploads = true;
 
    /* The queue size is the number of batches "waiting". Batches are removed
@@ -5595,6 +5645,7 @@ threaded_context_create(struct pipe_context *pipe,
       goto fail;
 
    tc->last_completed = -1;
+   tc->batch_slot_limit = TC_SLOTS_PER_BATCH - 1;
    for (unsigned i = 0; i < TC_MAX_BATCHES; i++) {
 #if !defined(NDEBUG) && TC_DEBUG >= 1
       tc->batch_slots[i].sentinel = TC_SENTINEL;
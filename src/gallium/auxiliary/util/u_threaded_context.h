@@ -259,6 +259,12 @@ struct tc_unflushed_batch_token;
  */
 #define TC_SLOTS_PER_BATCH    1536
 
+/* The smallest size a batch is allowed to shrink to when the driver thread
+ * is idle. Batches are flushed early in that case to hand work to the driver
+ * thread sooner, and grow back to TC_SLOTS_PER_BATCH when it falls behind.
+ */
+#define TC_MIN_SLOTS_PER_BATCH 192
+
 /* The buffer list queue is much deeper than the batch queue because buffer
  * lists need to stay around until the driver internally flushes its command
  * buffer.
@@ -671,6 +677,12 @@ struct threaded_context {
 
    unsigned last, next, next_buf_list;
 
+   /* Soft limit on the number of slots of a batch, adapted at every flush
+    * caused by a full batch, between TC_MIN_SLOTS_PER_BATCH and
+    * TC_SLOTS_PER_BATCH - 1.
+    */
+   unsigned batch_slot_limit;
+
    /* The list fences that the driver should signal after the next flush.
     * If this is empty, all driver command buffers have been flushed.
     */
@@ -38,6 +38,15 @@
 #include "u_upload_mgr.h"
 
 
+/* Number of filled buffers kept around for reuse. */
+#define U_UPLOAD_RING_SIZE 4
+
+struct u_upload_ring_entry {
+   struct pipe_resource *buffer;
+   struct pipe_transfer *transfer; /* persistent mapping, kept across reuse */
+   uint8_t *map;
+};
+
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
@@ -54,6 +63,14 @@ struct u_upload_mgr {
    unsigned buffer_size; /* Same as buffer->width0. */
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
+
+   /* Filled buffers waiting to become idle, oldest first. */
+   u_upload_is_busy_func is_busy;
+   void *is_busy_data;
+   struct u_upload_ring_entry ring[U_UPLOAD_RING_SIZE];
+   unsigned ring_count;
+
+   struct u_upload_stats stats;
 };
 
 
@@ -111,6 +128,21 @@ u_upload_clone(struct pipe_context *pipe, struct u_upload_mgr *upload)
    return result;
 }
 
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload,
+                          u_upload_is_busy_func is_busy, void *data)
+{
+   upload->is_busy = is_busy;
+   upload->is_busy_data = data;
+}
+
+void
+u_upload_get_stats(const struct u_upload_mgr *upload,
+                   struct u_upload_stats *stats)
+{
+   *stats = upload->stats;
+}
+
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload)
 {
@@ -154,14 +186,77 @@ u_upload_release_buffer(struct u_upload_mgr *upload)
 }
 
 
+static void
+u_upload_ring_pop(struct u_upload_mgr *upload)
+{
+   assert(upload->ring_count);
+   upload->ring_count--;
+   memmove(&upload->ring[0], &upload->ring[1],
+           upload->ring_count * sizeof(upload->ring[0]));
+}
+
+
 void
 u_upload_destroy(struct u_upload_mgr *upload)
 {
    u_upload_release_buffer(upload);
    pipe_resource_release(upload->pipe, upload->buffer);
+
+   while (upload->ring_count) {
+      pipe_buffer_unmap(upload->pipe, upload->ring[0].transfer);
+      pipe_resource_release(upload->pipe, upload->ring[0].buffer);
+      u_upload_ring_pop(upload);
+   }
    FREE(upload);
 }
 
+static bool
+u_upload_can_recycle(struct u_upload_mgr *upload)
+{
+   return upload->is_busy && upload->map_persistent && upload->transfer;
+}
+
+/* Move the current, filled buffer to the ring, keeping it mapped. */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   if (upload->ring_count == U_UPLOAD_RING_SIZE) {
+      /* The oldest buffer was still busy last time, drop it. */
+      pipe_buffer_unmap(upload->pipe, upload->ring[0].transfer);
+      pipe_resource_release(upload->pipe, upload->ring[0].buffer);
+      u_upload_ring_pop(upload);
+   }
+
+   struct u_upload_ring_entry *entry = &upload->ring[upload->ring_count++];
+   entry->buffer = upload->buffer;
+   entry->transfer = upload->transfer;
+   entry->map = upload->map;
+
+   upload->buffer = NULL;
+   upload->transfer = NULL;
+   upload->map = NULL;
+   upload->buffer_size = 0;
+}
+
+/* Take the oldest retired buffer if it is large enough and idle. */
+static bool
+u_upload_take_idle_buffer(struct u_upload_mgr *upload, unsigned min_size,
+                          struct u_upload_ring_entry *out)
+{
+   if (!upload->ring_count || upload->ring[0].buffer->width0 < min_size)
+      return false;
+
+   if (upload->is_busy(upload->is_busy_data, upload->ring[0].buffer)) {
+      upload->stats.recycle_stalls++;
+      return false;
+   }
+
+   *out = upload->ring[0];
+   u_upload_ring_pop(upload);
+   upload->stats.buffers_recycled++;
+   return true;
+}
+
 /* Return the allocated buffer size or 0 if it failed. */
 static unsigned
 u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size, struct pipe_resource **releasebuf)
@@ -170,11 +265,29 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size, struct pip
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
-    */
-   u_upload_release_buffer(upload);
-   *releasebuf = upload->buffer;
-   upload->buffer = NULL;
+   if (u_upload_can_recycle(upload)) {
+      struct u_upload_ring_entry idle;
+      bool recycled = u_upload_take_idle_buffer(upload, min_size, &idle);
+
+      /* The ring keeps the reference and the mapping. */
+      u_upload_retire_buffer(upload);
+      *releasebuf = NULL;
+
+      if (recycled) {
+         upload->buffer = idle.buffer;
+         upload->transfer = idle.transfer;
+         upload->map = idle.map;
+         upload->buffer_size = idle.buffer->width0;
+         upload->offset = 0;
+         return upload->buffer_size;
+      }
+   } else {
+      /* Release the old buffer, if present:
+       */
+      u_upload_release_buffer(upload);
+      *releasebuf = upload->buffer;
+      upload->buffer = NULL;
+   }
 
    /* Allocate a new one:
     */
@@ -200,6 +313,8 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size, struct pip
    if (upload->buffer == NULL)
       return 0;
 
+   upload->stats.buffers_created++;
+
    /* Map the new buffer. */
    upload->map = pipe_buffer_map_range(upload->pipe, upload->buffer,
                                        0, size, upload->map_flags,
@@ -289,6 +404,7 @@ u_upload_alloc(struct u_upload_mgr *upload,
    *outbuf = upload->buffer;
 
    upload->offset = offset + size;
+   upload->stats.bytes_uploaded += size;
 }
 
 void
@@ -38,6 +38,19 @@
 struct pipe_context;
 struct pipe_resource;
 
+/**
+ * Returns true if the GPU may still access the buffer, i.e. the commands
+ * that referenced it haven't retired yet.
+ */
+typedef bool (*u_upload_is_busy_func)(void *data, struct pipe_resource *buffer);
+
+struct u_upload_stats {
+   uint64_t bytes_uploaded;    /* sum of all suballocation sizes */
+   unsigned buffers_created;   /* upload buffers allocated from the screen */
+   unsigned buffers_recycled;  /* retired upload buffers reused */
+   unsigned recycle_stalls;    /* oldest retired buffer was still busy */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -73,6 +86,24 @@ u_upload_clone(struct pipe_context *pipe, struct u_upload_mgr *upload);
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload);
 
+/**
+ * Keep filled upload buffers and reuse them, persistently mapped, once
+ * is_busy reports that the GPU is done with them, instead of allocating a
+ * new buffer every time the current one fills up.
+ *
+ * Only effective with persistent mappings.
+ */
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload,
+                          u_upload_is_busy_func is_busy, void *data);
+
+/**
+ * Return the cumulative statistics of the upload manager.
+ */
+void
+u_upload_get_stats(const struct u_upload_mgr *upload,
+                   struct u_upload_stats *stats);
+
 /**
  * Destroy the upload manager.
  */
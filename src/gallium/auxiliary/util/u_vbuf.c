@@ -81,6 +81,16 @@
  * rate down.
  *
  *
+ * 3) Translated buffer cache (optional)
+ *
+ * If the frontend enables it and reports every write to vertex buffers with
+ * u_vbuf_invalidate_translated_buffers, translated vertices of non-user,
+ * non-persistent buffers are kept in their own buffers and reused by later
+ * draws with the same buffers, layout and range. This removes the per-draw
+ * translation for static VBOs in unsupported formats. The cache stops being
+ * used if it mostly misses, e.g. when the buffers are streamed.
+ *
+ *
  * If there is nothing to do, it forwards every command to the driver.
  * The module also has its own CSO cache of vertex element states.
  */
@@ -89,6 +99,7 @@
 
 #include "util/u_dump.h"
 #include "util/format/u_format.h"
+#include "util/hash_table.h"
 #include "util/u_helpers.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -99,7 +110,6 @@
 #include "translate/translate.h"
 #include "translate/translate_cache.h"
 #include "cso_cache/cso_cache.h"
-#include "cso_cache/cso_hash.h"
 
 struct u_vbuf_elements {
    unsigned count;
@@ -157,6 +167,39 @@ enum {
    VB_NUM = 3
 };
 
+/* The number of translated buffers kept by the cache. */
+#define U_VBUF_TRANSLATED_CACHE_SIZE 32
+
+/* The cache is disabled if it doesn't have at least 1 hit per this many
+ * misses after the first U_VBUF_TRANSLATED_CACHE_OPTIMISM misses.
+ */
+#define U_VBUF_TRANSLATED_CACHE_MISS_RATIO 4
+#define U_VBUF_TRANSLATED_CACHE_OPTIMISM 256
+
+struct u_vbuf_translated_source {
+   struct pipe_resource *resource;
+   unsigned buffer_offset;
+   unsigned stride;
+};
+
+struct u_vbuf_translated_key {
+   int start;
+   unsigned num;
+   unsigned max_index;
+   uint32_t vb_mask;
+   struct u_vbuf_translated_source vb[PIPE_MAX_ATTRIBS];
+};
+
+struct u_vbuf_translated_buffer {
+   struct u_vbuf_translated_key key;
+   struct translate_key translate_key;
+   uint32_t hash;
+   uint64_t last_used;
+
+   struct pipe_resource *buffer;
+   int buffer_offset;
+};
+
 struct u_vbuf {
    struct u_vbuf_caps caps;
    bool has_signed_vb_offset;
@@ -201,6 +244,11 @@ struct u_vbuf {
    uint32_t incompatible_vb_mask; /* each bit describes a corresp. buffer */
    /* Which buffers are allowed (supported by hardware). */
    uint32_t allowed_vb_mask;
+   /* Translated buffers, if the cache is enabled. */
+   struct u_vbuf_translated_buffer *translated;
+   unsigned num_translated;
+   uint64_t translated_clock;
+   unsigned translated_hits, translated_misses;
 };
 
 static void *
@@ -391,27 +439,31 @@ u_vbuf_set_vertex_elements_internal(struct u_vbuf *mgr,
                                     const struct cso_velems_state *velems)
 {
    struct pipe_context *pipe = mgr->pipe;
-   unsigned key_size, hash_key;
-   struct cso_hash_iter iter;
+   unsigned key_size;
+   uint64_t hash_key;
+   struct cso_velements *found;
    struct u_vbuf_elements *ve;
 
    /* need to include the count into the stored state data too. */
    key_size = sizeof(struct pipe_vertex_element) * velems->count +
               sizeof(unsigned);
    hash_key = cso_construct_key(velems, key_size);
-   iter = cso_find_state_template(&mgr->cso_cache, hash_key, CSO_VELEMENTS,
-                                  velems, key_size);
+   found = cso_find_state_template(&mgr->cso_cache, hash_key, CSO_VELEMENTS,
+                                   velems, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
+   if (!found) {
       struct cso_velements *cso = MALLOC_STRUCT(cso_velements);
       memcpy(&cso->state, velems, key_size);
       cso->data = u_vbuf_create_vertex_elements(mgr, velems->count,
                                                 velems->velems);
 
-      iter = cso_insert_state(&mgr->cso_cache, hash_key, CSO_VELEMENTS, cso);
+      if (!cso_insert_state(&mgr->cso_cache, hash_key, CSO_VELEMENTS, cso)) {
+         u_vbuf_delete_vertex_elements(pipe, cso, CSO_VELEMENTS);
+         return NULL;
+      }
       ve = cso->data;
    } else {
-      ve = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      ve = found->data;
    }
 
    assert(ve);
@@ -425,7 +477,12 @@ u_vbuf_set_vertex_elements_internal(struct u_vbuf *mgr,
 void u_vbuf_set_vertex_elements(struct u_vbuf *mgr,
                                 const struct cso_velems_state *velems)
 {
-   mgr->ve = u_vbuf_set_vertex_elements_internal(mgr, velems);
+   struct u_vbuf_elements *ve =
+      u_vbuf_set_vertex_elements_internal(mgr, velems);
+
+   /* On allocation failure the previous elements stay bound. */
+   if (ve)
+      mgr->ve = ve;
 }
 
 void u_vbuf_set_flatshade_first(struct u_vbuf *mgr, bool flatshade_first)
@@ -445,11 +502,160 @@ void u_vbuf_destroy(struct u_vbuf *mgr)
    if (mgr->pc)
       util_primconvert_destroy(mgr->pc);
 
+   u_vbuf_invalidate_translated_buffers(mgr, NULL);
+   FREE(mgr->translated);
    translate_cache_destroy(mgr->translate_cache);
    cso_cache_delete(&mgr->cso_cache);
    FREE(mgr);
 }
 
+void u_vbuf_enable_translated_buffer_cache(struct u_vbuf *mgr)
+{
+   if (!mgr->translated) {
+      mgr->translated = CALLOC(U_VBUF_TRANSLATED_CACHE_SIZE,
+                               sizeof(*mgr->translated));
+   }
+}
+
+static void
+u_vbuf_release_translated_buffer(struct u_vbuf_translated_buffer *entry)
+{
+   u_foreach_bit(i, entry->key.vb_mask)
+      pipe_resource_reference(&entry->key.vb[i].resource, NULL);
+   pipe_resource_reference(&entry->buffer, NULL);
+}
+
+void u_vbuf_invalidate_translated_buffers(struct u_vbuf *mgr,
+                                          struct pipe_resource *buffer)
+{
+   unsigned i = 0;
+
+   while (i < mgr->num_translated) {
+      struct u_vbuf_translated_buffer *entry = &mgr->translated[i];
+      bool uses_buffer = !buffer;
+
+      u_foreach_bit(vb, entry->key.vb_mask) {
+         if (entry->key.vb[vb].resource == buffer)
+            uses_buffer = true;
+      }
+
+      if (uses_buffer) {
+         u_vbuf_release_translated_buffer(entry);
+         *entry = mgr->translated[--mgr->num_translated];
+      } else {
+         i++;
+      }
+   }
+}
+
+/* Fill the cache key if the result of the translation only depends on
+ * the contents of buffers the frontend reports writes to.
+ */
+static bool
+u_vbuf_get_translated_key(struct u_vbuf *mgr,
+                          const struct pipe_draw_info *info,
+                          unsigned vb_mask, int start_vertex,
+                          unsigned num_vertices,
+                          struct u_vbuf_translated_key *out)
+{
+   if (!mgr->translated)
+      return false;
+
+   memset(out, 0, sizeof(*out));
+   out->start = start_vertex;
+   out->num = num_vertices;
+   out->max_index = info->max_index;
+   out->vb_mask = vb_mask;
+
+   u_foreach_bit(i, vb_mask) {
+      const struct pipe_vertex_buffer *vb = &mgr->vertex_buffer[i];
+
+      /* Persistent mappings can be written without any notification. */
+      if (vb->is_user_buffer || !vb->buffer.resource ||
+          vb->buffer.resource->flags & PIPE_RESOURCE_FLAG_MAP_PERSISTENT)
+         return false;
+
+      out->vb[i].resource = vb->buffer.resource;
+      out->vb[i].buffer_offset = vb->buffer_offset;
+      out->vb[i].stride = mgr->ve->strides[i];
+   }
+   return true;
+}
+
+static uint32_t
+u_vbuf_hash_translated_key(const struct u_vbuf_translated_key *key,
+                           const struct translate_key *translate_key)
+{
+   return _mesa_hash_data_with_seed(translate_key,
+                                    translate_keysize(translate_key),
+                                    _mesa_hash_data(key, sizeof(*key)));
+}
+
+static struct u_vbuf_translated_buffer *
+u_vbuf_find_translated_buffer(struct u_vbuf *mgr,
+                              const struct u_vbuf_translated_key *key,
+                              const struct translate_key *translate_key,
+                              uint32_t hash)
+{
+   for (unsigned i = 0; i < mgr->num_translated; i++) {
+      struct u_vbuf_translated_buffer *entry = &mgr->translated[i];
+
+      if (entry->hash == hash &&
+          !memcmp(&entry->key, key, sizeof(*key)) &&
+          !translate_key_compare(&entry->translate_key, translate_key)) {
+         entry->last_used = ++mgr->translated_clock;
+         mgr->translated_hits++;
+         return entry;
+      }
+   }
+
+   mgr->translated_misses++;
+
+   /* Streaming: translating into new buffers costs more than uploading. */
+   if (mgr->translated_misses > U_VBUF_TRANSLATED_CACHE_OPTIMISM &&
+       mgr->translated_hits * U_VBUF_TRANSLATED_CACHE_MISS_RATIO <
+       mgr->translated_misses) {
+      u_vbuf_invalidate_translated_buffers(mgr, NULL);
+      FREE(mgr->translated);
+      mgr->translated = NULL;
+   }
+   return NULL;
+}
+
+static void
+u_vbuf_add_translated_buffer(struct u_vbuf *mgr,
+                             const struct u_vbuf_translated_key *key,
+                             const struct translate_key *translate_key,
+                             uint32_t hash, struct pipe_resource *buffer,
+                             int buffer_offset)
+{
+   struct u_vbuf_translated_buffer *entry;
+
+   if (mgr->num_translated < U_VBUF_TRANSLATED_CACHE_SIZE) {
+      entry = &mgr->translated[mgr->num_translated++];
+   } else {
+      /* Replace the least recently used buffer. */
+      entry = &mgr->translated[0];
+      for (unsigned i = 1; i < mgr->num_translated; i++) {
+         if (mgr->translated[i].last_used < entry->last_used)
+            entry = &mgr->translated[i];
+      }
+      u_vbuf_release_translated_buffer(entry);
+   }
+
+   entry->key = *key;
+   u_foreach_bit(i, key->vb_mask) {
+      entry->key.vb[i].resource = NULL;
+      pipe_resource_reference(&entry->key.vb[i].resource, key->vb[i].resource);
+   }
+   memcpy(&entry->translate_key, translate_key, translate_keysize(translate_key));
+   entry->hash = hash;
+   entry->last_used = ++mgr->translated_clock;
+   entry->buffer = NULL;
+   pipe_resource_reference(&entry->buffer, buffer);
+   entry->buffer_offset = buffer_offset;
+}
+
 static enum pipe_error
 u_vbuf_translate_buffers(struct u_vbuf *mgr, struct translate_key *key,
                          const struct pipe_draw_info *info,
@@ -464,6 +670,31 @@ u_vbuf_translate_buffers(struct u_vbuf *mgr, struct translate_key *key,
    struct pipe_resource *out_buffer = NULL;
    uint8_t *out_map;
    unsigned out_offset, mask;
+   struct u_vbuf_translated_key cache_key;
+   uint32_t cache_hash = 0;
+   bool cacheable = !unroll_indices &&
+                    u_vbuf_get_translated_key(mgr, info, vb_mask,
+                                              start_vertex, num_vertices,
+                                              &cache_key);
+
+   if (cacheable) {
+      cache_hash = u_vbuf_hash_translated_key(&cache_key, key);
+
+      struct u_vbuf_translated_buffer *entry =
+         u_vbuf_find_translated_buffer(mgr, &cache_key, key, cache_hash);
+      if (entry) {
+         struct pipe_resource *buffer = NULL;
+
+         /* The driver takes ownership of this reference. */
+         pipe_resource_reference(&buffer, entry->buffer);
+         mgr->real_vertex_buffer[out_vb].buffer_offset = entry->buffer_offset;
+         mgr->real_vertex_buffer[out_vb].buffer.resource = buffer;
+         mgr->real_vertex_buffer[out_vb].is_user_buffer = false;
+         return PIPE_OK;
+      }
+      /* The cache may have been disabled. */
+      cacheable = mgr->translated != NULL;
+   }
 
    /* Get a translate object. */
    tr = translate_cache_find(mgr->translate_cache, key);
@@ -573,19 +804,49 @@ u_vbuf_translate_buffers(struct u_vbuf *mgr, struct translate_key *key,
          pipe_buffer_unmap(mgr->pipe, transfer);
       }
    } else {
-      /* Create and map the output buffer. */
-      u_upload_alloc(mgr->pipe->stream_uploader,
-                     mgr->has_signed_vb_offset ?
-                        0 : key->output_stride * start_vertex,
-                     key->output_stride * num_vertices, 4,
-                     &out_offset, &out_buffer, releasebuf,
-                     (void**)&out_map);
-      if (!out_buffer)
-         return PIPE_ERROR_OUT_OF_MEMORY;
+      struct pipe_transfer *transfer = NULL;
+      unsigned min_offset = mgr->has_signed_vb_offset ?
+                               0 : key->output_stride * start_vertex;
+      unsigned size = key->output_stride * num_vertices;
+
+      /* Create and map the output buffer. Cached vertices get a buffer of
+       * their own, so that it can be reused.
+       */
+      if (cacheable) {
+         out_buffer = pipe_buffer_create(mgr->pipe->screen,
+                                         PIPE_BIND_VERTEX_BUFFER,
+                                         PIPE_USAGE_IMMUTABLE,
+                                         min_offset + size);
+         out_map = out_buffer ?
+            pipe_buffer_map_range(mgr->pipe, out_buffer, min_offset, size,
+                                  PIPE_MAP_WRITE |
+                                  PIPE_MAP_DISCARD_WHOLE_RESOURCE,
+                                  &transfer) : NULL;
+         out_offset = min_offset;
+
+         if (!out_map) {
+            pipe_resource_reference(&out_buffer, NULL);
+            cacheable = false;
+         }
+      }
+
+      if (!cacheable) {
+         u_upload_alloc(mgr->pipe->stream_uploader, min_offset, size, 4,
+                        &out_offset, &out_buffer, releasebuf,
+                        (void**)&out_map);
+         if (!out_buffer)
+            return PIPE_ERROR_OUT_OF_MEMORY;
+      }
 
       out_offset -= key->output_stride * start_vertex;
 
       tr->run(tr, 0, num_vertices, 0, 0, out_map);
+
+      if (cacheable) {
+         pipe_buffer_unmap(mgr->pipe, transfer);
+         u_vbuf_add_translated_buffer(mgr, &cache_key, key, cache_hash,
+                                      out_buffer, out_offset);
+      }
    }
 
    /* Unmap all buffers. */
@@ -840,7 +1101,8 @@ u_vbuf_translate_begin(struct u_vbuf *mgr,
 
    mgr->fallback_velems.count = mgr->ve->count;
 
-   u_vbuf_set_vertex_elements_internal(mgr, &mgr->fallback_velems);
+   if (!u_vbuf_set_vertex_elements_internal(mgr, &mgr->fallback_velems))
+      return false;
    mgr->using_translate = true;
    return true;
 }
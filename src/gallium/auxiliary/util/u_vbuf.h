@@ -94,6 +94,14 @@ void u_vbuf_get_minmax_index(struct pipe_context *pipe,
                              const struct pipe_draw_start_count_bias *draw,
                              unsigned *out_min_index, unsigned *out_max_index);
 
+/* Keep translated vertices of non-user buffers for later draws. The caller
+ * must call u_vbuf_invalidate_translated_buffers whenever the contents of
+ * a vertex buffer change, or with NULL if it can't tell which one.
+ */
+void u_vbuf_enable_translated_buffer_cache(struct u_vbuf *mgr);
+void u_vbuf_invalidate_translated_buffers(struct u_vbuf *mgr,
+                                          struct pipe_resource *buffer);
+
 /* Save/restore functionality. */
 void u_vbuf_save_vertex_elements(struct u_vbuf *mgr);
 void u_vbuf_restore_vertex_elements(struct u_vbuf *mgr);
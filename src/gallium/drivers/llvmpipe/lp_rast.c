@@ -98,6 +98,79 @@ lp_rast_end(struct lp_rasterizer *rast)
 }
 
 
+/**
+ * Reset the per-block depth ranges of the current tile to "unknown".
+ * They only become useful once the bin clears the depth buffer.
+ */
+static void
+lp_rast_hiz_begin(struct lp_rasterizer_task *task)
+{
+   const struct lp_scene *scene = task->scene;
+
+   task->hiz.enabled = false;
+
+   if (!scene->fb.zsbuf.texture || scene->fb_max_layer > 0 ||
+       (LP_PERF & PERF_NO_HIZ))
+      return;
+
+   const struct util_format_description *desc =
+      util_format_description(scene->fb.zsbuf.format);
+   if (!util_format_has_depth(desc))
+      return;
+
+   /* Skipping blocks changes the number of fragment shader invocations. */
+   for (unsigned i = 0; i < scene->num_active_queries; i++) {
+      if (scene->active_queries[i]->type == PIPE_QUERY_PIPELINE_STATISTICS)
+         return;
+   }
+
+   /* Depth values are compared after conversion to the buffer format, so
+    * allow for a couple of quantization steps of slack.
+    */
+   const struct util_format_channel_description *chan =
+      &desc->channel[desc->swizzle[0]];
+   if (chan->type == UTIL_FORMAT_TYPE_FLOAT)
+      task->hiz.eps = 0.0f;
+   else
+      task->hiz.eps = 2.0f / (float)((1ull << chan->size) - 1);
+
+   for (unsigned i = 0; i < LP_HIZ_BLOCKS; i++) {
+      task->hiz.zmin[i] = -INFINITY;
+      task->hiz.zmax[i] = INFINITY;
+   }
+
+   task->hiz.enabled = true;
+}
+
+
+/**
+ * Set the depth range of all blocks of the current tile after a depth
+ * clear.
+ */
+static void
+lp_rast_hiz_clear(struct lp_rasterizer_task *task,
+                  uint64_t clear_value, uint64_t clear_mask)
+{
+   const enum pipe_format format = task->scene->fb.zsbuf.format;
+   const uint64_t zmask = util_pack64_mask_z(format, ~0u);
+   float zmin = -INFINITY, zmax = INFINITY;
+
+   if ((clear_mask & zmask) == 0)
+      return;
+
+   if ((clear_mask & zmask) == zmask) {
+      float z;
+      util_format_unpack_z_float(format, &z, &clear_value, 1);
+      zmin = zmax = z;
+   }
+
+   for (unsigned i = 0; i < LP_HIZ_BLOCKS; i++) {
+      task->hiz.zmin[i] = zmin;
+      task->hiz.zmax[i] = zmax;
+   }
+}
+
+
 /**
  * Beginning rasterization of a tile.
  * \param x  window X position of the tile, in pixels
@@ -135,6 +208,8 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
    }
+
+   lp_rast_hiz_begin(task);
 }
 
 
@@ -207,6 +282,9 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
    LP_DBG(DEBUG_RAST, "%s: value=0x%08x, mask=0x%08x\n",
            __func__, clear_value, clear_mask);
 
+   if (task->hiz.enabled)
+      lp_rast_hiz_clear(task, clear_value64, clear_mask64);
+
    /*
     * Clear the area of the depth/depth buffer matching this tile.
     */
@@ -326,6 +404,10 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
 
    const struct lp_fragment_shader_variant *variant = state->variant;
 
+   if (task->hiz.enabled &&
+       lp_rast_hiz_reject(task, inputs, tile_x, tile_y, TILE_SIZE))
+      return;
+
    unsigned view_index = inputs->view_index;
    /* render the whole 64x64 tile in 4x4 chunks */
    for (unsigned y = 0; y < task->height; y += 4){
@@ -473,6 +555,9 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
     * allocated 4x4 blocks hence need to filter them out here.
     */
    if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+      if (task->hiz.enabled && lp_rast_hiz_reject(task, inputs, x, y, 4))
+         return;
+
       /* Propagate non-interpolated raster state. */
       lp_rast_task_init_thread_data(&task->thread_data, inputs);
 
@@ -645,6 +730,8 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
       pq->start[task->thread_index] = task->thread_data.ps_invocations;
+      /* Block rejection would skew the fragment shader invocation count. */
+      task->hiz.enabled = false;
       break;
    case PIPE_QUERY_TIME_ELAPSED:
       pq->start[task->thread_index] = os_time_get_nano();
@@ -28,7 +28,9 @@
 #ifndef LP_RAST_PRIV_H
 #define LP_RAST_PRIV_H
 
+#include <float.h>
 #include "util/format/u_format.h"
+#include "util/u_math.h"
 #include "util/u_thread.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
@@ -37,6 +39,7 @@
 #include "lp_state.h"
 #include "lp_texture.h"
 #include "lp_limits.h"
+#include "lp_perf.h"
 
 
 #define TILE_VECTOR_HEIGHT 4
@@ -76,6 +79,11 @@ extern const struct lp_rasterizer_task *jit_task;
 struct lp_rasterizer;
 struct cmd_bin;
 
+/** Granularity of the conservative depth ranges kept per tile */
+#define LP_HIZ_BLOCK_SIZE 16
+#define LP_HIZ_BLOCKS_X (TILE_SIZE / LP_HIZ_BLOCK_SIZE)
+#define LP_HIZ_BLOCKS (LP_HIZ_BLOCKS_X * LP_HIZ_BLOCKS_X)
+
 /**
  * Per-thread rasterization state
  */
@@ -100,6 +108,19 @@ struct lp_rasterizer_task
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
+   /**
+    * Conservative [zmin, zmax] of the depth buffer contents for each
+    * 16x16 block of the current tile (layer 0 only).  Established by
+    * depth clears and widened by depth writes while processing the bin,
+    * used to skip blocks which would fail the depth test entirely.
+    */
+   struct {
+      bool enabled;
+      float eps;               /**< depth buffer quantization margin */
+      float zmin[LP_HIZ_BLOCKS];
+      float zmax[LP_HIZ_BLOCKS];
+   } hiz;
+
    util_semaphore work_ready;
    util_semaphore work_done;
 #ifdef _WIN32
@@ -150,6 +171,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
                          unsigned mask);
 
 
+
 /**
  * Get the pointer to a 4x4 color block (within a 64x64 tile).
  * \param x, y location of 4x4 block in window coords
@@ -218,6 +240,129 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Conservative per-block depth rejection.
+ *
+ * Returns true if every fragment of the triangle within the size x size
+ * area at x, y (window coords) is guaranteed to fail the depth test, in
+ * which case the fragment shader needn't run.  Otherwise accounts for
+ * the depth values the shader may write to the area and returns false.
+ */
+static inline bool
+lp_rast_hiz_reject(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   unsigned x, unsigned y, unsigned size)
+{
+   const struct lp_rast_state *state = task->state;
+   const struct lp_fragment_shader_variant *variant = state->variant;
+
+   if (variant->hiz_func == PIPE_FUNC_ALWAYS &&
+       variant->hiz_write == LP_HIZ_WRITE_NONE)
+      return false;
+
+   /* Only layer 0 is tracked. */
+   if (inputs->layer || inputs->view_index)
+      return false;
+
+   const unsigned bx0 = (x % TILE_SIZE) / LP_HIZ_BLOCK_SIZE;
+   const unsigned by0 = (y % TILE_SIZE) / LP_HIZ_BLOCK_SIZE;
+   const unsigned bx1 = ((x % TILE_SIZE) + size - 1) / LP_HIZ_BLOCK_SIZE;
+   const unsigned by1 = ((y % TILE_SIZE) + size - 1) / LP_HIZ_BLOCK_SIZE;
+
+   if (variant->hiz_write == LP_HIZ_WRITE_UNKNOWN) {
+      for (unsigned by = by0; by <= by1; by++) {
+         for (unsigned bx = bx0; bx <= bx1; bx++) {
+            task->hiz.zmin[by * LP_HIZ_BLOCKS_X + bx] = -INFINITY;
+            task->hiz.zmax[by * LP_HIZ_BLOCKS_X + bx] = INFINITY;
+         }
+      }
+      return false;
+   }
+
+   /* Range of the z plane over the area, with a pixel of margin to cover
+    * pixel centers and sample positions, and slack for the different
+    * rounding of the JIT'd interpolation.  Setup stores the polygon
+    * offset in the otherwise unused x component of the position a0, and
+    * the interpolation adds it to z before any clamping.
+    */
+   const float z0 = GET_A0(inputs)[0][2] + GET_A0(inputs)[0][0];
+   const float dzdx = GET_DADX(inputs)[0][2];
+   const float dzdy = GET_DADY(inputs)[0][2];
+   const float x0 = (float)x - 1.0f, x1 = (float)(x + size) + 1.0f;
+   const float y0 = (float)y - 1.0f, y1 = (float)(y + size) + 1.0f;
+   const float za = z0 + dzdx * x0 + dzdy * y0;
+   const float zb = z0 + dzdx * x1 + dzdy * y0;
+   const float zc = z0 + dzdx * x0 + dzdy * y1;
+   const float zd = z0 + dzdx * x1 + dzdy * y1;
+   const float err = (fabsf(z0) + fabsf(dzdx) * x1 + fabsf(dzdy) * y1) *
+                     (16.0f * FLT_EPSILON);
+   float tzmin = MIN4(za, zb, zc, zd) - err;
+   float tzmax = MAX4(za, zb, zc, zd) + err;
+
+   if (util_is_inf_or_nan(tzmin) || util_is_inf_or_nan(tzmax))
+      return false;
+
+   /* Clamping is monotonic, so clamping the bounds bounds the result. */
+   if (variant->key.restrict_depth_values) {
+      tzmin = MAX2(MIN2(tzmin, 1.0f), 0.0f);
+      tzmax = MAX2(MIN2(tzmax, 1.0f), 0.0f);
+   }
+   if (variant->key.depth_clamp) {
+      const struct lp_jit_viewport *vp =
+         &state->jit_context.viewports[inputs->viewport_index];
+      tzmin = MAX2(MIN2(tzmin, vp->max_depth), vp->min_depth);
+      tzmax = MAX2(MIN2(tzmax, vp->max_depth), vp->min_depth);
+   }
+
+   if (variant->hiz_func != PIPE_FUNC_ALWAYS) {
+      float zmin = INFINITY, zmax = -INFINITY;
+      for (unsigned by = by0; by <= by1; by++) {
+         for (unsigned bx = bx0; bx <= bx1; bx++) {
+            zmin = MIN2(zmin, task->hiz.zmin[by * LP_HIZ_BLOCKS_X + bx]);
+            zmax = MAX2(zmax, task->hiz.zmax[by * LP_HIZ_BLOCKS_X + bx]);
+         }
+      }
+
+      const float eps = task->hiz.eps;
+      bool reject;
+      switch (variant->hiz_func) {
+      case PIPE_FUNC_LESS:
+         reject = tzmin >= zmax + eps;
+         break;
+      case PIPE_FUNC_LEQUAL:
+         reject = tzmin > zmax + eps;
+         break;
+      case PIPE_FUNC_GREATER:
+         reject = tzmax <= zmin - eps;
+         break;
+      case PIPE_FUNC_GEQUAL:
+         reject = tzmax < zmin - eps;
+         break;
+      default:
+         reject = false;
+         break;
+      }
+
+      if (reject) {
+         LP_COUNT(nr_hiz_reject);
+         return true;
+      }
+   }
+
+   if (variant->hiz_write == LP_HIZ_WRITE_PLANE) {
+      for (unsigned by = by0; by <= by1; by++) {
+         for (unsigned bx = bx0; bx <= bx1; bx++) {
+            const unsigned i = by * LP_HIZ_BLOCKS_X + bx;
+            task->hiz.zmin[i] = MIN2(task->hiz.zmin[i], tzmin);
+            task->hiz.zmax[i] = MAX2(task->hiz.zmax[i], tzmax);
+         }
+      }
+   }
+
+   return false;
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
@@ -269,6 +414,9 @@ lp_rast_shade_quads_all(struct lp_rasterizer_task *task,
     * allocated 4x4 blocks hence need to filter them out here.
     */
    if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+      if (task->hiz.enabled && lp_rast_hiz_reject(task, inputs, x, y, 4))
+         return;
+
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
       task->thread_data.raster_state.view_index = inputs->view_index;
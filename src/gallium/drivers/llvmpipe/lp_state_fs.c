@@ -3808,6 +3808,8 @@ lp_debug_fs_variant(struct lp_fragment_shader_variant *variant)
    debug_printf("variant->opaque = %u\n", variant->opaque);
    debug_printf("variant->potentially_opaque = %u\n", variant->potentially_opaque);
    debug_printf("variant->blit = %u\n", variant->blit);
+   debug_printf("variant->hiz_func = %u\n", variant->hiz_func);
+   debug_printf("variant->hiz_write = %u\n", variant->hiz_write);
    debug_printf("shader->kind = %s\n", lp_debug_fs_kind(variant->shader->kind));
    debug_printf("\n");
 }
@@ -3932,6 +3934,32 @@ generate_variant(struct llvmpipe_context *lp,
          shader->info.cbuf[0][3].file != TGSI_FILE_NULL
          ? true : false;
 
+   /* Blocks can only be rejected on depth alone when failing the depth
+    * test has no other side effect.  Shader computed depth can't be
+    * bounded from the position plane.
+    */
+   const bool writes_z =
+      nir->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_DEPTH);
+
+   variant->hiz_func = PIPE_FUNC_ALWAYS;
+   if (key->depth.enabled &&
+       !writes_z &&
+       !key->stencil[0].enabled &&
+       !nir->info.writes_memory &&
+       (key->depth.func == PIPE_FUNC_LESS ||
+        key->depth.func == PIPE_FUNC_LEQUAL ||
+        key->depth.func == PIPE_FUNC_GREATER ||
+        key->depth.func == PIPE_FUNC_GEQUAL)) {
+      variant->hiz_func = key->depth.func;
+   }
+
+   if (key->depth.enabled && key->depth.writemask) {
+      variant->hiz_write = writes_z ? LP_HIZ_WRITE_UNKNOWN
+                                    : LP_HIZ_WRITE_PLANE;
+   } else {
+      variant->hiz_write = LP_HIZ_WRITE_NONE;
+   }
+
    /* We only care about opaque blits for now */
    if (variant->opaque &&
        (shader->kind == LP_FS_KIND_BLIT_RGBA ||
@@ -137,6 +137,14 @@ lp_fs_variant_key_images(struct lp_fragment_shader_variant_key *key)
                                              key->nr_sampler_views)]);
 }
 
+/** How a fragment shader variant affects the depth buffer contents. */
+enum lp_hiz_write {
+   LP_HIZ_WRITE_NONE,      /**< no depth writes */
+   LP_HIZ_WRITE_PLANE,     /**< writes the interpolated z */
+   LP_HIZ_WRITE_UNKNOWN,   /**< writes shader computed depth */
+};
+
+
 struct lp_fragment_shader_variant
 {
    struct util_shader_variant base;
@@ -150,6 +158,14 @@ struct lp_fragment_shader_variant
    unsigned blit:1;
    unsigned linear_input_mask:16;
 
+   /*
+    * Per-block depth range handling in the rasterizer, see
+    * lp_rast_hiz_reject().  hiz_func is the depth func blocks can be
+    * rejected against, or PIPE_FUNC_ALWAYS if they can't be.
+    */
+   unsigned hiz_func:3;
+   unsigned hiz_write:2;   /**< LP_HIZ_WRITE_x */
+
    struct gallivm_state *gallivm;
 
    lp_jit_frag_func jit_function[2]; // [RAST_WHOLE], [RAST_EDGE_TEST]
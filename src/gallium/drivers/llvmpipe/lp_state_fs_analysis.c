@@ -337,10 +337,13 @@ llvmpipe_nir_fn_is_linear_compat(const struct nir_shader *shader,
                      if (!check_load_const_in_zero_one(load)) {
                         return false;
                      }
-                  } else if (is_fs_input(&alu->src[s].src)) {
-                     /* we don't know if the fs inputs are in [0,1] */
-                     return false;
                   }
+                  /* FS inputs (e.g. a per-vertex color or opacity
+                   * modulating a texture) are fine here: the linear
+                   * interpolator checks at rasterization time that the
+                   * input stays within [0,1] over the whole rectangle
+                   * and falls back to the JIT path otherwise.
+                   */
                }
                break;
             }
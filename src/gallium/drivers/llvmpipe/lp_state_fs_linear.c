@@ -667,8 +667,11 @@ llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
       return;
    }
 
+   /* The RGB1 shader always emits alpha = 1, so premultiplied-alpha
+    * blending reduces to a plain copy of the source.
+    */
    if (variant->shader->kind == LP_FS_KIND_BLIT_RGB1 &&
-       variant->opaque &&
+       (variant->opaque || is_one_inv_src_alpha_blend(variant)) &&
        (tex_format == PIPE_FORMAT_B8G8R8A8_UNORM ||
         tex_format == PIPE_FORMAT_B8G8R8X8_UNORM) &&
        is_nearest_clamp_sampler(samp0)) {
@@ -1734,34 +1734,46 @@ VKAPI_ATTR void VKAPI_CALL lvp_GetPhysicalDeviceQueueFamilyProperties2(
 {
    VK_OUTARRAY_MAKE_TYPED(VkQueueFamilyProperties2, out, pQueueFamilyProperties, pCount);
 
-   VkQueueFamilyGlobalPriorityPropertiesKHR *prio = vk_find_struct(pQueueFamilyProperties, QUEUE_FAMILY_GLOBAL_PRIORITY_PROPERTIES_KHR);
-   if (prio) {
-      prio->priorityCount = 4;
-      prio->priorities[0] = VK_QUEUE_GLOBAL_PRIORITY_LOW_KHR;
-      prio->priorities[1] = VK_QUEUE_GLOBAL_PRIORITY_MEDIUM_KHR;
-      prio->priorities[2] = VK_QUEUE_GLOBAL_PRIORITY_HIGH_KHR;
-      prio->priorities[3] = VK_QUEUE_GLOBAL_PRIORITY_REALTIME_KHR;
-   }
-   VkQueueFamilyOptimalImageTransferGranularityPropertiesKHR *gran = vk_find_struct(pQueueFamilyProperties, QUEUE_FAMILY_OPTIMAL_IMAGE_TRANSFER_GRANULARITY_PROPERTIES_KHR);
-   if (gran) {
-      gran->optimalImageTransferGranularity.width = 1;
-      gran->optimalImageTransferGranularity.height = 1;
-      gran->optimalImageTransferGranularity.depth = 1;
-   }
-   VkQueueFamilyOwnershipTransferPropertiesKHR *prop = vk_find_struct(pQueueFamilyProperties, QUEUE_FAMILY_OWNERSHIP_TRANSFER_PROPERTIES_KHR);
-   if (prop)
-      prop->optimalImageTransferToQueueFamilies = ~0;
-
-   vk_outarray_append_typed(VkQueueFamilyProperties2, &out, p) {
-      p->queueFamilyProperties = (VkQueueFamilyProperties) {
-         .queueFlags = VK_QUEUE_GRAPHICS_BIT |
-         VK_QUEUE_COMPUTE_BIT |
-         VK_QUEUE_TRANSFER_BIT |
-         (DETECT_OS_LINUX ? VK_QUEUE_SPARSE_BINDING_BIT : 0),
-         .queueCount = 1,
-         .timestampValidBits = 64,
-         .minImageTransferGranularity = (VkExtent3D) { 1, 1, 1 },
-      };
+   /* Family 0 is the universal family, family 1 is compute-only. Every queue
+    * gets its own submit thread and pipe context, so independent submissions
+    * execute concurrently on the shared rasterizer and cs thread pools.
+    */
+   static const VkQueueFlags family_flags[LVP_NUM_QUEUE_FAMILIES] = {
+      VK_QUEUE_GRAPHICS_BIT |
+      VK_QUEUE_COMPUTE_BIT |
+      VK_QUEUE_TRANSFER_BIT |
+      (DETECT_OS_LINUX ? VK_QUEUE_SPARSE_BINDING_BIT : 0),
+      VK_QUEUE_COMPUTE_BIT |
+      VK_QUEUE_TRANSFER_BIT,
+   };
+
+   for (uint32_t f = 0; f < LVP_NUM_QUEUE_FAMILIES; f++) {
+      vk_outarray_append_typed(VkQueueFamilyProperties2, &out, p) {
+         p->queueFamilyProperties = (VkQueueFamilyProperties) {
+            .queueFlags = family_flags[f],
+            .queueCount = LVP_MAX_QUEUES_PER_FAMILY,
+            .timestampValidBits = 64,
+            .minImageTransferGranularity = (VkExtent3D) { 1, 1, 1 },
+         };
+
+         VkQueueFamilyGlobalPriorityPropertiesKHR *prio = vk_find_struct(p, QUEUE_FAMILY_GLOBAL_PRIORITY_PROPERTIES_KHR);
+         if (prio) {
+            prio->priorityCount = 4;
+            prio->priorities[0] = VK_QUEUE_GLOBAL_PRIORITY_LOW_KHR;
+            prio->priorities[1] = VK_QUEUE_GLOBAL_PRIORITY_MEDIUM_KHR;
+            prio->priorities[2] = VK_QUEUE_GLOBAL_PRIORITY_HIGH_KHR;
+            prio->priorities[3] = VK_QUEUE_GLOBAL_PRIORITY_REALTIME_KHR;
+         }
+         VkQueueFamilyOptimalImageTransferGranularityPropertiesKHR *gran = vk_find_struct(p, QUEUE_FAMILY_OPTIMAL_IMAGE_TRANSFER_GRANULARITY_PROPERTIES_KHR);
+         if (gran) {
+            gran->optimalImageTransferGranularity.width = 1;
+            gran->optimalImageTransferGranularity.height = 1;
+            gran->optimalImageTransferGranularity.depth = 1;
+         }
+         VkQueueFamilyOwnershipTransferPropertiesKHR *prop = vk_find_struct(p, QUEUE_FAMILY_OWNERSHIP_TRANSFER_PROPERTIES_KHR);
+         if (prop)
+            prop->optimalImageTransferToQueueFamilies = ~0;
+      }
    }
 }
 
@@ -1855,6 +1867,7 @@ destroy_pipelines(struct lvp_queue *queue)
    while (util_dynarray_contains(&queue->pipeline_destroys, struct lvp_pipeline*)) {
       lvp_pipeline_destroy(device, util_dynarray_pop(&queue->pipeline_destroys, struct lvp_pipeline*), true);
    }
+   p_atomic_set(&queue->num_pipeline_destroys, 0);
    simple_mtx_unlock(&queue->lock);
 }
 
@@ -1908,7 +1921,14 @@ lvp_queue_submit(struct vk_queue *vk_queue,
          vk_sync_as_lvp_pipe_sync(submit->signals[i].sync);
       lvp_pipe_sync_signal_with_fence(device, sync, queue->last_fence);
    }
-   destroy_pipelines(queue);
+
+   /* Deferred pipeline destruction always goes through the primary queue's
+    * context. Other queues only help drain it when there is work pending so
+    * that they do not wait on the primary queue's lock for every submit.
+    */
+   if (queue == &device->queue ||
+       p_atomic_read(&device->queue.num_pipeline_destroys))
+      destroy_pipelines(&device->queue);
 
    return VK_SUCCESS;
 }
@@ -1956,6 +1976,61 @@ lvp_queue_finish(struct lvp_queue *queue)
    queue->ctx->destroy(queue->ctx);
 }
 
+static void
+lvp_device_finish_extra_queues(struct lvp_device *device)
+{
+   for (uint32_t i = 0; i < device->extra_queue_count; i++) {
+      struct lvp_queue *queue = &device->extra_queues[i];
+
+      if (queue->last_fence)
+         device->pscreen->fence_reference(device->pscreen, &queue->last_fence, NULL);
+      lvp_queue_finish(queue);
+      vk_free(&device->vk.alloc, queue->state);
+   }
+   vk_free(&device->vk.alloc, device->extra_queues);
+   device->extra_queues = NULL;
+   device->extra_queue_count = 0;
+}
+
+static VkResult
+lvp_device_init_extra_queues(struct lvp_device *device,
+                             const VkDeviceCreateInfo *pCreateInfo,
+                             uint32_t count)
+{
+   device->extra_queues = vk_zalloc(&device->vk.alloc,
+                                    count * sizeof(*device->extra_queues), 8,
+                                    VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+   if (!device->extra_queues)
+      return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
+
+   for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; i++) {
+      const VkDeviceQueueCreateInfo *create_info = &pCreateInfo->pQueueCreateInfos[i];
+
+      /* The primary queue is index 0 of the first create info. */
+      for (uint32_t q = i == 0 ? 1 : 0; q < create_info->queueCount; q++) {
+         struct lvp_queue *queue = &device->extra_queues[device->extra_queue_count];
+
+         queue->state = vk_zalloc(&device->vk.alloc, lvp_get_rendering_state_size(), 8,
+                                  VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+         if (!queue->state) {
+            lvp_device_finish_extra_queues(device);
+            return vk_error(device, VK_ERROR_OUT_OF_HOST_MEMORY);
+         }
+
+         VkResult result = lvp_queue_init(device, queue, create_info, q);
+         if (result != VK_SUCCESS) {
+            vk_free(&device->vk.alloc, queue->state);
+            lvp_device_finish_extra_queues(device);
+            return result;
+         }
+         device->extra_queue_count++;
+      }
+   }
+   assert(device->extra_queue_count == count);
+
+   return VK_SUCCESS;
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
    VkPhysicalDevice                            physicalDevice,
    const VkDeviceCreateInfo*                   pCreateInfo,
@@ -1999,15 +2074,28 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
 
    device->pscreen = physical_device->pscreen;
 
-   assert(pCreateInfo->queueCreateInfoCount <= LVP_NUM_QUEUES);
-   if (pCreateInfo->queueCreateInfoCount) {
-      assert(pCreateInfo->pQueueCreateInfos[0].queueFamilyIndex == 0);
-      assert(pCreateInfo->pQueueCreateInfos[0].queueCount == 1);
+   assert(pCreateInfo->queueCreateInfoCount <= LVP_NUM_QUEUE_FAMILIES);
+   uint32_t queue_count = 0;
+   for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; i++) {
+      assert(pCreateInfo->pQueueCreateInfos[i].queueFamilyIndex < LVP_NUM_QUEUE_FAMILIES);
+      assert(pCreateInfo->pQueueCreateInfos[i].queueCount <= LVP_MAX_QUEUES_PER_FAMILY);
+      queue_count += pCreateInfo->pQueueCreateInfos[i].queueCount;
+   }
+
+   if (queue_count) {
+      /* The first queue requested becomes the primary queue, whose context
+       * is also used for device-level operations. The others are extras.
+       */
       result = lvp_queue_init(device, &device->queue, pCreateInfo->pQueueCreateInfos, 0);
+      if (result == VK_SUCCESS && queue_count > 1) {
+         result = lvp_device_init_extra_queues(device, pCreateInfo, queue_count - 1);
+         if (result != VK_SUCCESS)
+            lvp_queue_finish(&device->queue);
+      }
    } else {
       /* VK_KHR_maintenance9 allows zero queues devices used to compile shaders only.
-      *  Since we only ever create a single queue, and it has no hardward backing it,
-      *  we can just create a dummy queue on the behalf of the user.
+      *  Since the queue has no hardware backing it, we can just create a dummy
+      *  queue on the behalf of the user.
       */
       const float fake_priority = 1.0f;
       const VkDeviceQueueCreateInfo dummy_create_info = {
@@ -2033,6 +2121,7 @@ VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateDevice(
    device->noop_fs = device->queue.ctx->create_fs_state(device->queue.ctx, &shstate);
    _mesa_hash_table_init(&device->bda, NULL, _mesa_hash_pointer, _mesa_key_pointer_equal);
    simple_mtx_init(&device->bda_lock, mtx_plain);
+   simple_mtx_init(&device->pipeline_queue_lock, mtx_plain);
 
    uint32_t zero = 0;
    device->zero_buffer = pipe_buffer_create_with_data(device->queue.ctx, 0, PIPE_USAGE_IMMUTABLE, sizeof(uint32_t), &zero);
@@ -2094,8 +2183,12 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyDevice(
       device->pscreen->fence_reference(device->pscreen, &device->queue.last_fence, NULL);
    _mesa_hash_table_fini(&device->bda, NULL);
    simple_mtx_destroy(&device->bda_lock);
+   if (util_queue_is_initialized(&device->pipeline_queue))
+      util_queue_destroy(&device->pipeline_queue);
+   simple_mtx_destroy(&device->pipeline_queue_lock);
    pipe_resource_reference(&device->zero_buffer, NULL);
 
+   lvp_device_finish_extra_queues(device);
    lvp_queue_finish(&device->queue);
    vk_device_finish(&device->vk);
    vk_free(&device->vk.alloc, device);
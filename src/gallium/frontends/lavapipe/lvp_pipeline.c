@@ -30,6 +30,7 @@
 #include "vk_util.h"
 #include "glsl_types.h"
 #include "util/os_time.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_inlines.h"
 #include "spirv/nir_spirv.h"
 #include "nir/nir_builder.h"
@@ -122,6 +123,7 @@ VKAPI_ATTR void VKAPI_CALL lvp_DestroyPipeline(
    if (pipeline->used) {
       simple_mtx_lock(&device->queue.lock);
       util_dynarray_append(&device->queue.pipeline_destroys, pipeline);
+      p_atomic_inc(&device->queue.num_pipeline_destroys);
       simple_mtx_unlock(&device->queue.lock);
    } else {
       lvp_pipeline_destroy(device, pipeline, false);
@@ -1190,43 +1192,6 @@ lvp_graphics_pipeline_create(
    return VK_SUCCESS;
 }
 
-VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
-   VkDevice                                    _device,
-   VkPipelineCache                             pipelineCache,
-   uint32_t                                    count,
-   const VkGraphicsPipelineCreateInfo*         pCreateInfos,
-   const VkAllocationCallbacks*                pAllocator,
-   VkPipeline*                                 pPipelines)
-{
-   VkResult result = VK_SUCCESS;
-   unsigned i = 0;
-
-   for (; i < count; i++) {
-      VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
-      VkPipelineCreateFlagBits2KHR flags = vk_graphics_pipeline_create_flags(&pCreateInfos[i]);
-
-      if (!(flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR))
-         r = lvp_graphics_pipeline_create(_device,
-                                          pipelineCache,
-                                          &pCreateInfos[i],
-                                          flags,
-                                          &pPipelines[i],
-                                          false);
-      if (r != VK_SUCCESS) {
-         result = r;
-         pPipelines[i] = VK_NULL_HANDLE;
-         if (flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
-            break;
-      }
-   }
-   if (result != VK_SUCCESS) {
-      for (; i < count; i++)
-         pPipelines[i] = VK_NULL_HANDLE;
-   }
-
-   return result;
-}
-
 static VkResult
 lvp_compute_pipeline_init(struct lvp_pipeline *pipeline,
                           struct lvp_device *device,
@@ -1296,43 +1261,164 @@ lvp_compute_pipeline_create(
    return VK_SUCCESS;
 }
 
-VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateComputePipelines(
-   VkDevice                                    _device,
-   VkPipelineCache                             pipelineCache,
-   uint32_t                                    count,
-   const VkComputePipelineCreateInfo*          pCreateInfos,
-   const VkAllocationCallbacks*                pAllocator,
-   VkPipeline*                                 pPipelines)
+/* Pipelines in a batch are independent, so they are created in parallel on a
+ * per-device thread pool. The calling thread takes part as well.
+ */
+#define LVP_PIPELINE_BATCH_SIZE 32
+
+struct lvp_pipeline_create_job {
+   struct util_queue_fence fence;
+   VkDevice device;
+   VkPipelineCache cache;
+   const VkGraphicsPipelineCreateInfo *graphics_info;
+   const VkComputePipelineCreateInfo *compute_info;
+   VkPipelineCreateFlagBits2KHR flags;
+   VkPipeline *pipeline;
+   VkResult result;
+};
+
+static void
+lvp_pipeline_create_job_execute(void *data, void *gdata, int thread_index)
 {
-   VkResult result = VK_SUCCESS;
-   unsigned i = 0;
+   struct lvp_pipeline_create_job *job = data;
+
+   if (job->graphics_info)
+      job->result = lvp_graphics_pipeline_create(job->device, job->cache, job->graphics_info,
+                                                 job->flags, job->pipeline, false);
+   else
+      job->result = lvp_compute_pipeline_create(job->device, job->cache, job->compute_info,
+                                                job->flags, job->pipeline);
+}
 
-   for (; i < count; i++) {
-      VkResult r = VK_PIPELINE_COMPILE_REQUIRED;
-      VkPipelineCreateFlagBits2KHR flags = vk_compute_pipeline_create_flags(&pCreateInfos[i]);
+static struct util_queue *
+lvp_get_pipeline_queue(struct lvp_device *device)
+{
+   unsigned num_threads = util_get_cpu_caps()->nr_cpus;
+   if (num_threads <= 1)
+      return NULL;
 
-      if (!(flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR))
-         r = lvp_compute_pipeline_create(_device,
-                                         pipelineCache,
-                                         &pCreateInfos[i],
-                                         flags,
-                                         &pPipelines[i]);
-      if (r != VK_SUCCESS) {
-         result = r;
-         pPipelines[i] = VK_NULL_HANDLE;
-         if (flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
-            break;
-      }
+   simple_mtx_lock(&device->pipeline_queue_lock);
+   if (!util_queue_is_initialized(&device->pipeline_queue)) {
+      /* The calling thread compiles too, so one worker fewer than cpus. */
+      util_queue_init(&device->pipeline_queue, "lvp_pipe", LVP_PIPELINE_BATCH_SIZE,
+                      MIN2(num_threads - 1, LVP_PIPELINE_BATCH_SIZE),
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
    }
-   if (result != VK_SUCCESS) {
-      for (; i < count; i++)
+   simple_mtx_unlock(&device->pipeline_queue_lock);
+
+   return util_queue_is_initialized(&device->pipeline_queue) ? &device->pipeline_queue : NULL;
+}
+
+static VkResult
+lvp_create_pipelines(VkDevice _device,
+                     VkPipelineCache pipelineCache,
+                     uint32_t count,
+                     const VkGraphicsPipelineCreateInfo *graphics_infos,
+                     const VkComputePipelineCreateInfo *compute_infos,
+                     VkPipeline *pPipelines)
+{
+   VK_FROM_HANDLE(lvp_device, device, _device);
+   struct util_queue *queue = count > 1 ? lvp_get_pipeline_queue(device) : NULL;
+   struct lvp_pipeline_create_job jobs[LVP_PIPELINE_BATCH_SIZE];
+   VkResult result = VK_SUCCESS;
+   bool early_return = false;
+
+   for (uint32_t base = 0; base < count; base += LVP_PIPELINE_BATCH_SIZE) {
+      uint32_t batch = MIN2(count - base, LVP_PIPELINE_BATCH_SIZE);
+      struct lvp_pipeline_create_job *inline_job = NULL;
+
+      for (uint32_t j = 0; j < batch; j++) {
+         struct lvp_pipeline_create_job *job = &jobs[j];
+         uint32_t i = base + j;
+
+         *job = (struct lvp_pipeline_create_job) {
+            .device = _device,
+            .cache = pipelineCache,
+            .graphics_info = graphics_infos ? &graphics_infos[i] : NULL,
+            .compute_info = compute_infos ? &compute_infos[i] : NULL,
+            .flags = graphics_infos ? vk_graphics_pipeline_create_flags(&graphics_infos[i]) :
+                                      vk_compute_pipeline_create_flags(&compute_infos[i]),
+            .pipeline = &pPipelines[i],
+            .result = VK_PIPELINE_COMPILE_REQUIRED,
+         };
          pPipelines[i] = VK_NULL_HANDLE;
-   }
+         util_queue_fence_init(&job->fence);
 
+         if (job->flags & VK_PIPELINE_CREATE_2_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_KHR)
+            continue;
+
+         /* Keep the last pipeline of the batch for the calling thread. */
+         if (!queue || j == batch - 1) {
+            if (inline_job)
+               lvp_pipeline_create_job_execute(inline_job, NULL, 0);
+            inline_job = job;
+         } else {
+            util_queue_add_job(queue, job, &job->fence,
+                               lvp_pipeline_create_job_execute, NULL, 0);
+         }
+      }
+
+      if (inline_job)
+         lvp_pipeline_create_job_execute(inline_job, NULL, 0);
+
+      /* Report results in order, as if the batch had been created serially:
+       * once a pipeline fails with EARLY_RETURN_ON_FAILURE, the ones after it
+       * must not exist.
+       */
+      for (uint32_t j = 0; j < batch; j++) {
+         struct lvp_pipeline_create_job *job = &jobs[j];
+
+         util_queue_fence_wait(&job->fence);
+         util_queue_fence_destroy(&job->fence);
+
+         if (early_return) {
+            if (*job->pipeline) {
+               lvp_pipeline_destroy(device, lvp_pipeline_from_handle(*job->pipeline), false);
+               *job->pipeline = VK_NULL_HANDLE;
+            }
+            continue;
+         }
+
+         if (job->result != VK_SUCCESS) {
+            result = job->result;
+            *job->pipeline = VK_NULL_HANDLE;
+            if (job->flags & VK_PIPELINE_CREATE_2_EARLY_RETURN_ON_FAILURE_BIT_KHR)
+               early_return = true;
+         }
+      }
+
+      if (early_return) {
+         for (uint32_t i = base + batch; i < count; i++)
+            pPipelines[i] = VK_NULL_HANDLE;
+         break;
+      }
+   }
 
    return result;
 }
 
+VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateGraphicsPipelines(
+   VkDevice                                    _device,
+   VkPipelineCache                             pipelineCache,
+   uint32_t                                    count,
+   const VkGraphicsPipelineCreateInfo*         pCreateInfos,
+   const VkAllocationCallbacks*                pAllocator,
+   VkPipeline*                                 pPipelines)
+{
+   return lvp_create_pipelines(_device, pipelineCache, count, pCreateInfos, NULL, pPipelines);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL lvp_CreateComputePipelines(
+   VkDevice                                    _device,
+   VkPipelineCache                             pipelineCache,
+   uint32_t                                    count,
+   const VkComputePipelineCreateInfo*          pCreateInfos,
+   const VkAllocationCallbacks*                pAllocator,
+   VkPipeline*                                 pPipelines)
+{
+   return lvp_create_pipelines(_device, pipelineCache, count, NULL, pCreateInfos, pPipelines);
+}
+
 VKAPI_ATTR void VKAPI_CALL lvp_DestroyShaderEXT(
     VkDevice                                    _device,
     VkShaderEXT                                 _shader,
@@ -98,7 +98,8 @@ typedef uint32_t xcb_window_t;
 extern "C" {
 #endif
 
-#define LVP_NUM_QUEUES 1
+#define LVP_NUM_QUEUE_FAMILIES 2
+#define LVP_MAX_QUEUES_PER_FAMILY 4
 #define MAX_SETS 8
 #define MAX_DESCRIPTORS ((1<<20) - (1<<15)) /* Required by VK_EXT_descriptor_heap */
 #define MAX_PUSH_CONSTANTS_SIZE 256
@@ -198,6 +199,7 @@ struct lvp_queue {
    struct pipe_fence_handle *last_fence;
    void *state;
    struct util_dynarray pipeline_destroys;
+   unsigned num_pipeline_destroys; /* read without the lock */
    simple_mtx_t lock;
 };
 
@@ -216,6 +218,11 @@ struct lvp_device {
    struct vk_device vk;
 
    struct lvp_queue queue;
+   /* Queues beyond the first one created. Each has its own pipe context and
+    * submit thread; they share the screen's rasterizer and cs thread pools.
+    */
+   struct lvp_queue *extra_queues;
+   uint32_t extra_queue_count;
    struct pipe_screen *pscreen;
    void *noop_fs;
    simple_mtx_t bda_lock;
@@ -231,6 +238,10 @@ struct lvp_device {
 
    uint32_t group_handle_alloc;
 
+   /* Worker threads for vkCreate*Pipelines batches, created on first use. */
+   simple_mtx_t pipeline_queue_lock;
+   struct util_queue pipeline_queue;
+
    struct vk_meta_device meta;
    radix_sort_vk_t *radix_sort;
    simple_mtx_t radix_sort_lock;
@@ -87,6 +87,17 @@ _mesa_initialize_vao(struct gl_context *ctx,
                      struct gl_vertex_array_object *obj, GLuint name);
 
 
+/**
+ * Drop the vertex elements state cached for the VAO. This must be called
+ * when anything that vertex elements are built from changes.
+ */
+static inline void
+_mesa_vao_invalidate_vertex_elements(struct gl_vertex_array_object *vao)
+{
+   vao->VertexElements.Handle = NULL;
+}
+
+
 extern void
 _mesa_update_vao_derived_arrays(struct gl_context *ctx,
                                 struct gl_vertex_array_object *vao,
@@ -1210,6 +1210,7 @@ copy_array_object(struct gl_context *ctx,
    dest->NonZeroDivisorMask = src->NonZeroDivisorMask;
    dest->NonIdentityBufferAttribMapping = src->NonIdentityBufferAttribMapping;
    dest->_AttributeMapMode = src->_AttributeMapMode;
+   _mesa_vao_invalidate_vertex_elements(dest);
    /* skip NumUpdates and IsDynamic because they can only increase, not decrease */
 }
 
@@ -41,8 +41,11 @@ memory_barrier(struct gl_context *ctx, GLbitfield barriers)
    struct pipe_context *pipe = ctx->pipe;
    unsigned flags = 0;
 
-   if (barriers & GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT)
+   if (barriers & GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT) {
+      /* Shaders may have written vertex buffers. */
+      st_buffer_written(st_context(ctx), NULL);
       flags |= PIPE_BARRIER_VERTEX_BUFFER;
+   }
    if (barriers & GL_ELEMENT_ARRAY_BARRIER_BIT)
       flags |= PIPE_BARRIER_INDEX_BUFFER;
    if (barriers & GL_UNIFORM_BARRIER_BIT)
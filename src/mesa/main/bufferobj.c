@@ -53,6 +53,7 @@
 
 #include "state_tracker/st_debug.h"
 #include "state_tracker/st_atom.h"
+#include "state_tracker/st_context.h"
 #include "frontend/api.h"
 
 #include "util/u_inlines.h"
@@ -113,6 +114,7 @@ _mesa_bufferobj_subdata(struct gl_context *ctx,
     */
    struct pipe_context *pipe = ctx->pipe;
 
+   st_buffer_written(ctx->st, obj->buffer);
    pipe->buffer_subdata(pipe, obj->buffer,
                         _mesa_bufferobj_mapped(obj, MAP_USER) ?
                            PIPE_MAP_DIRECTLY : 0,
@@ -288,6 +290,10 @@ bufferobj_data(struct gl_context *ctx,
       return GL_FALSE;
    }
 
+   /* This either replaces or overwrites the current contents. */
+   if (obj->buffer)
+      st_buffer_written(ctx->st, obj->buffer);
+
    if (target != GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD &&
        size && obj->buffer &&
        obj->Size == size &&
@@ -351,10 +357,14 @@ bufferobj_data(struct gl_context *ctx,
          obj->buffer = screen->resource_from_memobj(screen, &buffer,
                                                     memObj->memory,
                                                     offset);
+         /* Can be written by other APIs without notice. */
+         ctx->Shared->HasExternalBuffers = true;
       }
       else if (target == GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD) {
          obj->buffer =
             screen->resource_from_user_memory(screen, &buffer, (void*)data);
+         /* Can be written by the application without notice. */
+         ctx->Shared->HasExternalBuffers = true;
       }
       else {
          obj->buffer = screen->resource_create(screen, &buffer);
@@ -506,6 +516,14 @@ _mesa_bufferobj_map_range(struct gl_context *ctx,
    if (ctx->Const.ForceMapBufferSynchronized)
       transfer_flags &= ~PIPE_MAP_UNSYNCHRONIZED;
 
+   /* Thread-safe maps come from glthread's upload buffers, which are
+    * mapped on the application thread and only ever written at fresh
+    * offsets, so they can't invalidate translated vertices.
+    */
+   if (transfer_flags & PIPE_MAP_WRITE &&
+       !(transfer_flags & PIPE_MAP_THREAD_SAFE))
+      st_buffer_written(ctx->st, obj->buffer);
+
    obj->Mappings[index].Pointer = pipe_buffer_map_range(pipe,
                                                         obj->buffer,
                                                         offset, length,
@@ -596,6 +614,8 @@ bufferobj_copy_subdata(struct gl_context *ctx,
    if (!size)
       return;
 
+   st_buffer_written(ctx->st, dst->buffer);
+
    /* buffer should not already be mapped */
    assert(!_mesa_check_disallowed_mapping(src));
    /* dst can be mapped, just not the same range as the target range */
@@ -2777,6 +2797,7 @@ clear_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
       return;
 
    bufObj->MinMaxCacheDirty = true;
+   st_buffer_written(ctx->st, bufObj->buffer);
 
    if (!ctx->pipe->clear_buffer) {
       clear_buffer_subdata_sw(ctx, offset, size,
@@ -768,6 +768,17 @@ vbo_destroy_vertex_list(struct gl_context *ctx, struct vbo_save_vertex_list *nod
    free(node->cold);
 }
 
+/**
+ * Return the number of draws executing the node results in.  Loopback
+ * replays each primitive as a glBegin/End pair.
+ */
+static unsigned
+vbo_vertex_list_draw_count(const struct vbo_save_vertex_list *node, OpCode op)
+{
+   return op == OPCODE_VERTEX_LIST_LOOPBACK ? node->cold->prim_count :
+                                              node->num_draws;
+}
+
 static void
 vbo_print_vertex_list(struct gl_context *ctx, struct vbo_save_vertex_list *node, OpCode op, FILE *f)
 {
@@ -780,11 +791,11 @@ vbo_print_vertex_list(struct gl_context *ctx, struct vbo_save_vertex_list *node,
       "VBO-VERTEX-LIST", "VBO-VERTEX-LIST-LOOPBACK", "VBO-VERTEX-LIST-COPY-CURRENT"
    };
 
-   fprintf(f, "%s, %u vertices, %d primitives, %d vertsize, "
+   fprintf(f, "%s, %u vertices, %d primitives, %u draws, %d vertsize, "
            "buffer %p\n",
            label[op - OPCODE_VERTEX_LIST],
-           node->cold->vertex_count, node->cold->prim_count, vertex_size,
-           buffer);
+           node->cold->vertex_count, node->cold->prim_count,
+           vbo_vertex_list_draw_count(node, op), vertex_size, buffer);
 
    for (i = 0; i < node->cold->prim_count; i++) {
       struct _mesa_prim *prim = &node->cold->prims[i];
@@ -1680,6 +1691,83 @@ invalidate_saved_current_state(struct gl_context *ctx)
 }
 
 
+/**
+ * Forget the state cached in ListState.Current to eliminate redundant state
+ * changes, after a command that may have changed it (glPopAttrib).
+ */
+static void
+invalidate_saved_server_state(struct gl_context *ctx)
+{
+   ctx->ListState.Current.ShadeModel = 0;
+   ctx->ListState.Current.LineWidth = 0;
+   ctx->ListState.Current.PointSize = 0;
+   ctx->ListState.Current.EnabledKnown = 0;
+}
+
+
+/**
+ * Return the bit of ListState.Current.Enabled tracking \p cap, or 0 if
+ * redundant changes of this cap aren't eliminated.  These are the caps
+ * commonly toggled between primitives by applications drawing many small
+ * objects.
+ */
+static GLbitfield
+saved_cap_bit(GLenum cap)
+{
+   switch (cap) {
+   case GL_LIGHT0:
+   case GL_LIGHT1:
+   case GL_LIGHT2:
+   case GL_LIGHT3:
+   case GL_LIGHT4:
+   case GL_LIGHT5:
+   case GL_LIGHT6:
+   case GL_LIGHT7:
+      return BITFIELD_BIT(cap - GL_LIGHT0);
+   case GL_LIGHTING:              return BITFIELD_BIT(8);
+   case GL_COLOR_MATERIAL:        return BITFIELD_BIT(9);
+   case GL_NORMALIZE:             return BITFIELD_BIT(10);
+   case GL_RESCALE_NORMAL:        return BITFIELD_BIT(11);
+   case GL_CULL_FACE:             return BITFIELD_BIT(12);
+   case GL_DEPTH_TEST:            return BITFIELD_BIT(13);
+   case GL_LINE_SMOOTH:           return BITFIELD_BIT(14);
+   case GL_LINE_STIPPLE:          return BITFIELD_BIT(15);
+   case GL_POLYGON_STIPPLE:       return BITFIELD_BIT(16);
+   case GL_POLYGON_OFFSET_FILL:   return BITFIELD_BIT(17);
+   case GL_POLYGON_OFFSET_LINE:   return BITFIELD_BIT(18);
+   case GL_POLYGON_OFFSET_POINT:  return BITFIELD_BIT(19);
+   default:
+      return 0;
+   }
+}
+
+
+/**
+ * Record that \p cap is set to \p state by the list being compiled.
+ * Return true if it is already known to be in that state, so that the call
+ * doesn't need to be compiled.
+ */
+static bool
+save_cap_state(struct gl_context *ctx, GLenum cap, bool state)
+{
+   const GLbitfield bit = saved_cap_bit(cap);
+
+   if (!bit)
+      return false;
+
+   if ((ctx->ListState.Current.EnabledKnown & bit) &&
+       !!(ctx->ListState.Current.Enabled & bit) == state)
+      return true;
+
+   ctx->ListState.Current.EnabledKnown |= bit;
+   if (state)
+      ctx->ListState.Current.Enabled |= bit;
+   else
+      ctx->ListState.Current.Enabled &= ~bit;
+   return false;
+}
+
+
 static void GLAPIENTRY
 save_CallList(GLuint list)
 {
@@ -2267,14 +2355,25 @@ save_Disable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op (see save_ShadeModel). */
+   const bool redundant = save_cap_state(ctx, cap, false);
+
+   if (!redundant)
+      SAVE_FLUSH_VERTICES(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_Disable(ctx->Dispatch.Exec, (cap));
+   }
+
+   if (redundant)
+      return;
+
    n = alloc_instruction(ctx, OPCODE_DISABLE, 1);
    if (n) {
       n[1].e = cap;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_Disable(ctx->Dispatch.Exec, (cap));
-   }
 }
 
 
@@ -2342,14 +2441,25 @@ save_Enable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op (see save_ShadeModel). */
+   const bool redundant = save_cap_state(ctx, cap, true);
+
+   if (!redundant)
+      SAVE_FLUSH_VERTICES(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_Enable(ctx->Dispatch.Exec, (cap));
+   }
+
+   if (redundant)
+      return;
+
    n = alloc_instruction(ctx, OPCODE_ENABLE, 1);
    if (n) {
       n[1].e = cap;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_Enable(ctx->Dispatch.Exec, (cap));
-   }
 }
 
 
@@ -2768,14 +2878,30 @@ save_LineWidth(GLfloat width)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op (see save_ShadeModel).
+    * Invalid widths are never cached, so their error is still raised.
+    */
+   const bool redundant =
+      ctx->ListState.Current.LineWidth == width && width > 0.0f;
+
+   if (!redundant)
+      SAVE_FLUSH_VERTICES(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_LineWidth(ctx->Dispatch.Exec, (width));
+   }
+
+   if (redundant)
+      return;
+
+   ctx->ListState.Current.LineWidth = width;
+
    n = alloc_instruction(ctx, OPCODE_LINE_WIDTH, 1);
    if (n) {
       n[1].f = width;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_LineWidth(ctx->Dispatch.Exec, (width));
-   }
 }
 
 
@@ -3315,14 +3441,28 @@ save_PointSize(GLfloat size)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op (see save_ShadeModel). */
+   const bool redundant =
+      ctx->ListState.Current.PointSize == size && size > 0.0f;
+
+   if (!redundant)
+      SAVE_FLUSH_VERTICES(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_PointSize(ctx->Dispatch.Exec, (size));
+   }
+
+   if (redundant)
+      return;
+
+   ctx->ListState.Current.PointSize = size;
+
    n = alloc_instruction(ctx, OPCODE_POINT_SIZE, 1);
    if (n) {
       n[1].f = size;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_PointSize(ctx->Dispatch.Exec, (size));
-   }
 }
 
 
@@ -3403,6 +3543,7 @@ save_PopAttrib(void)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
+   invalidate_saved_server_state(ctx);
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Dispatch.Exec, ());
    }
@@ -3767,18 +3908,25 @@ save_ShadeModel(GLenum mode)
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
 
-   if (ctx->ExecuteFlag) {
-      CALL_ShadeModel(ctx->Dispatch.Exec, (mode));
-   }
-
    /* Don't compile this call if it's a no-op.
     * By avoiding this state change we have a better chance of
     * coalescing subsequent drawing commands into one batch.
     */
-   if (ctx->ListState.Current.ShadeModel == mode)
-      return;
+   const bool redundant = ctx->ListState.Current.ShadeModel == mode;
 
-   SAVE_FLUSH_VERTICES(ctx);
+   /* Flush before executing the call, so that the pending primitives are
+    * compiled and, with GL_COMPILE_AND_EXECUTE, drawn with the previous
+    * state.
+    */
+   if (!redundant)
+      SAVE_FLUSH_VERTICES(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_ShadeModel(ctx->Dispatch.Exec, (mode));
+   }
+
+   if (redundant)
+      return;
 
    ctx->ListState.Current.ShadeModel = mode;
 
@@ -13641,6 +13789,7 @@ print_list(struct gl_context *ctx, GLuint list, const char *fname)
    struct gl_display_list *dlist;
    Node *n;
    FILE *f = stdout;
+   unsigned num_vertex_lists = 0, num_prims = 0, num_draws = 0;
 
    if (fname) {
       f = fopen(fname, "w");
@@ -13908,6 +14057,10 @@ print_list(struct gl_context *ctx, GLuint list, const char *fname)
          case OPCODE_VERTEX_LIST_LOOPBACK:
          case OPCODE_VERTEX_LIST_COPY_CURRENT:
             vbo_print_vertex_list(ctx, (struct vbo_save_vertex_list *) &n[0], opcode, f);
+            num_vertex_lists++;
+            num_prims += ((struct vbo_save_vertex_list *) &n[0])->cold->prim_count;
+            num_draws += vbo_vertex_list_draw_count((struct vbo_save_vertex_list *) &n[0],
+                                                    opcode);
             break;
          default:
             if (opcode < 0 || opcode > OPCODE_END_OF_LIST) {
@@ -13921,7 +14074,9 @@ print_list(struct gl_context *ctx, GLuint list, const char *fname)
             }
             FALLTHROUGH;
          case OPCODE_END_OF_LIST:
-            fprintf(f, "END-LIST %u\n", list);
+            fprintf(f, "END-LIST %u, %u primitives in %u vertex lists "
+                    "replayed as %u draws\n",
+                    list, num_prims, num_vertex_lists, num_draws);
             fflush(f);
             if (fname)
                fclose(f);
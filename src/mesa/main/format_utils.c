@@ -29,6 +29,8 @@
 #include "glformats.h"
 #include "format_pack.h"
 #include "format_unpack.h"
+#include "sse_swizzle.h"
+#include "util/u_cpu_detect.h"
 
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(MESA_ARRAY_FORMAT_BASE_FORMAT_RGBA_VARIANTS,
@@ -704,6 +706,24 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+#if defined(USE_SSE41)
+/**
+ * Whether every destination channel comes from a source channel or is zero
+ * or one, which is what _mesa_swizzle_ubyte_rgba_sse41 supports.
+ */
+static bool
+swizzle_is_ubyte_shuffle(const uint8_t swizzle[4], int num_src_channels)
+{
+   for (unsigned i = 0; i < 4; i++) {
+      if (swizzle[i] >= num_src_channels &&
+          swizzle[i] != MESA_FORMAT_SWIZZLE_ZERO &&
+          swizzle[i] != MESA_FORMAT_SWIZZLE_ONE)
+         return false;
+   }
+   return true;
+}
+#endif
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1423,6 +1443,29 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+#if defined(USE_SSE41)
+   /* RGB8 to RGBA8 and the RGBA8/BGRA8 swaps are the most common texture
+    * upload conversions. Do them with byte shuffles and let the generic
+    * loop below handle the remaining pixels.
+    */
+   if (dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+       src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+       num_dst_channels == 4 &&
+       (num_src_channels == 3 || num_src_channels == 4) &&
+       swizzle_is_ubyte_shuffle(swizzle, num_src_channels) &&
+       util_get_cpu_caps()->has_sse4_1) {
+      int done = _mesa_swizzle_ubyte_rgba_sse41(void_dst, void_src,
+                                                num_src_channels, swizzle,
+                                                normalized ? UINT8_MAX : 1,
+                                                count);
+      void_dst = (uint8_t *)void_dst + done * 4;
+      void_src = (const uint8_t *)void_src + done * num_src_channels;
+      count -= done;
+      if (!count)
+         return;
+   }
+#endif
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
@@ -37,7 +37,9 @@
 #include "main/glthread_marshal.h"
 #include "main/hash.h"
 #include "main/pixelstore.h"
+#include "util/hash_table.h"
 #include "util/u_atomic.h"
+#include "util/u_debug.h"
 #include "util/u_thread.h"
 #include "util/u_cpu_detect.h"
 #include "util/thread_sched.h"
@@ -156,6 +158,8 @@ glthread_unmarshal_batch(void *job, void *gdata, int thread_index)
    _mesa_glthread_signal_call(&ctx->GLThread.LastDListChangeBatchIndex, batch_index);
 
    p_atomic_inc(&ctx->GLThread.stats.num_batches);
+   p_atomic_inc(&ctx->GLThread.stats.total_batches);
+   p_atomic_add(&ctx->GLThread.stats.total_batch_bytes, (uint64_t)used * 8);
 }
 
 static void
@@ -243,11 +247,16 @@ _mesa_glthread_init(struct gl_context *ctx)
    }
    glthread->next_batch = &glthread->batches[glthread->next];
    glthread->used = 0;
+   glthread->batch_limit = MARSHAL_DEFAULT_BATCH_SIZE / 8 - 1;
    glthread->stats.queue = &glthread->queue;
 
    _mesa_glthread_init_call_fence(&glthread->LastProgramChangeBatch);
    _mesa_glthread_init_call_fence(&glthread->LastDListChangeBatchIndex);
 
+   if (debug_get_bool_option("MESA_GLTHREAD_REPORT_SYNCS", false))
+      glthread->SyncCounts = _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                                     _mesa_key_string_equal);
+
    _mesa_glthread_enable(ctx);
 
    /* Execute the thread initialization function in the thread. */
@@ -270,6 +279,48 @@ free_vao(void *data, UNUSED void *userData)
    free(data);
 }
 
+static int
+compare_sync_counts(const void *a, const void *b)
+{
+   const struct hash_entry *ea = *(const struct hash_entry **)a;
+   const struct hash_entry *eb = *(const struct hash_entry **)b;
+   uintptr_t ca = (uintptr_t)ea->data;
+   uintptr_t cb = (uintptr_t)eb->data;
+
+   return ca < cb ? 1 : ca > cb ? -1 : strcmp(ea->key, eb->key);
+}
+
+/* Print the entry points that synchronized, most frequent first. */
+static void
+glthread_report_syncs(struct glthread_state *glthread)
+{
+   struct hash_table *counts = glthread->SyncCounts;
+
+   if (!glthread->stats.num_syncs) {
+      fprintf(stderr, "glthread: no syncs\n");
+      return;
+   }
+
+   const struct hash_entry **entries =
+      malloc(MAX2(counts->entries, 1) * sizeof(*entries));
+   unsigned num = 0;
+
+   if (!entries)
+      return;
+
+   hash_table_foreach(counts, entry)
+      entries[num++] = entry;
+
+   qsort(entries, num, sizeof(*entries), compare_sync_counts);
+
+   fprintf(stderr, "glthread: %u syncs in total\n", glthread->stats.num_syncs);
+   for (unsigned i = 0; i < num; i++) {
+      fprintf(stderr, "glthread: %10" PRIuPTR " gl%s\n",
+              (uintptr_t)entries[i]->data, (const char *)entries[i]->key);
+   }
+   free(entries);
+}
+
 void
 _mesa_glthread_destroy(struct gl_context *ctx)
 {
@@ -285,6 +336,12 @@ _mesa_glthread_destroy(struct gl_context *ctx)
 
       _mesa_DeinitHashTable(&glthread->VAOs, free_vao, NULL);
       _mesa_glthread_release_upload_buffer(ctx, false);
+
+      if (glthread->SyncCounts) {
+         glthread_report_syncs(glthread);
+         _mesa_hash_table_destroy(glthread->SyncCounts, NULL);
+         glthread->SyncCounts = NULL;
+      }
    }
 }
 
@@ -372,12 +429,34 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
    glthread_finalize_batch(glthread, &glthread->stats.num_offloaded_items);
 
    struct glthread_batch *next = glthread->next_batch;
+   unsigned next_index = (glthread->next + 1) % MARSHAL_MAX_BATCHES;
+   struct util_queue_fence *oldest = &glthread->batches[next_index].fence;
+
+   /* The batch we fill next is the oldest one.  If it hasn't been executed
+    * yet, all batches are in use and the queue is full, so we have to wait
+    * for the worker thread either way.  Do it here to measure the stall.
+    */
+   if (!util_queue_fence_is_signalled(oldest)) {
+      int64_t start = os_time_get_nano();
+      util_queue_fence_wait(oldest);
+      p_atomic_add(&glthread->stats.total_stall_time_ns,
+                   os_time_get_nano() - start);
+   }
 
    util_queue_add_job(&glthread->queue, next, &next->fence,
                       glthread_unmarshal_batch, NULL, 0);
    glthread->last = glthread->next;
-   glthread->next = (glthread->next + 1) % MARSHAL_MAX_BATCHES;
+   glthread->next = next_index;
    glthread->next_batch = &glthread->batches[glthread->next];
+
+   /* If a number of batches got full without any synchronization, the app
+    * is issuing a lot of calls. Larger batches reduce the u_queue overhead.
+    */
+   if (glthread->num_full_batches >= MARSHAL_MAX_BATCHES) {
+      glthread->num_full_batches = 0;
+      glthread->batch_limit = MIN2((glthread->batch_limit + 1) * 2,
+                                   MARSHAL_MAX_CMD_BUFFER_SIZE / 8) - 1;
+   }
 }
 
 /**
@@ -385,13 +464,16 @@ _mesa_glthread_flush_batch(struct gl_context *ctx)
  *
  * This can be used by the main thread to synchronize access to the context,
  * since the worker thread will be idle after this.
+ *
+ * Returns whether the main thread had to wait or execute calls, i.e.
+ * whether it was counted as a sync.
  */
-void
+bool
 _mesa_glthread_finish(struct gl_context *ctx)
 {
    struct glthread_state *glthread = &ctx->GLThread;
    if (!glthread->enabled)
-      return;
+      return false;
 
    /* If this is called from the worker thread, then we've hit a path that
     * might be called from either the main thread or the worker (such as some
@@ -399,13 +481,15 @@ _mesa_glthread_finish(struct gl_context *ctx)
     * synchronize against ourself.
     */
    if (u_thread_is_self(glthread->queue.threads[0]))
-      return;
+      return false;
 
    struct glthread_batch *last = &glthread->batches[glthread->last];
    struct glthread_batch *next = glthread->next_batch;
+   int64_t start = 0;
    bool synced = false;
 
    if (!util_queue_fence_is_signalled(&last->fence)) {
+      start = os_time_get_nano();
       util_queue_fence_wait(&last->fence);
       synced = true;
    }
@@ -413,6 +497,9 @@ _mesa_glthread_finish(struct gl_context *ctx)
    glthread_apply_thread_sched_policy(ctx, false);
 
    if (glthread->used) {
+      if (!start)
+         start = os_time_get_nano();
+
       glthread_finalize_batch(glthread, &glthread->stats.num_direct_items);
 
       /* Since glthread_unmarshal_batch changes the dispatch to direct,
@@ -428,17 +515,38 @@ _mesa_glthread_finish(struct gl_context *ctx)
       synced = true;
    }
 
-   if (synced)
+   if (synced) {
       p_atomic_inc(&glthread->stats.num_syncs);
+      p_atomic_add(&glthread->stats.total_stall_time_ns,
+                   os_time_get_nano() - start);
+
+      /* If the app synchronized before any batch got full, smaller batches
+       * let the worker thread start earlier, so that there is less to wait
+       * for at the next synchronization.
+       */
+      if (!glthread->num_full_batches) {
+         glthread->batch_limit = MAX2((glthread->batch_limit + 1) / 2,
+                                      MARSHAL_MIN_BATCH_SIZE / 8) - 1;
+      }
+      glthread->num_full_batches = 0;
+   }
+   return synced;
 }
 
 void
 _mesa_glthread_finish_before(struct gl_context *ctx, const char *func)
 {
-   _mesa_glthread_finish(ctx);
+   struct hash_table *counts = ctx->GLThread.SyncCounts;
+
+   if (!_mesa_glthread_finish(ctx) || !counts)
+      return;
 
-   /* Uncomment this if you want to know where glthread syncs. */
-   /*printf("fallback to sync: %s\n", func);*/
+   /* The names are string literals, so they don't need to be copied. */
+   struct hash_entry *entry = _mesa_hash_table_search(counts, func);
+   if (entry)
+      entry->data = (void *)((uintptr_t)entry->data + 1);
+   else
+      _mesa_hash_table_insert(counts, func, (void *)(uintptr_t)1);
 }
 
 void
@@ -24,7 +24,7 @@
 #ifndef _GLTHREAD_H
 #define _GLTHREAD_H
 
-/* The size of one batch and the maximum size of one call.
+/* The initial size of one batch and the maximum size of one call.
  *
  * This should be as low as possible, so that:
  * - multiple synchronizations within a frame don't slow us down much
@@ -33,12 +33,20 @@
  *   chance of experiencing CPU cache thrashing
  * but it should be high enough so that u_queue overhead remains negligible.
  */
-#define MARSHAL_MAX_CMD_BUFFER_SIZE (8 * 1024)
+#define MARSHAL_DEFAULT_BATCH_SIZE (8 * 1024)
+
+/* The range the batch size adapts within.  Batches grow when they keep
+ * getting full between synchronizations, which happens with apps that
+ * issue a lot of small calls, and shrink when the app thread synchronizes
+ * before a batch is full.
+ */
+#define MARSHAL_MIN_BATCH_SIZE (2 * 1024)
+#define MARSHAL_MAX_CMD_BUFFER_SIZE (32 * 1024)
 
 /* We need to leave 1 slot at the end to insert the END marker for unmarshal
  * calls that look ahead to know where the batch ends.
  */
-#define MARSHAL_MAX_CMD_SIZE (MARSHAL_MAX_CMD_BUFFER_SIZE - 8)
+#define MARSHAL_MAX_CMD_SIZE (MARSHAL_DEFAULT_BATCH_SIZE - 8)
 
 /* The number of batch slots in memory.
  *
@@ -203,6 +211,12 @@ struct glthread_state
    /** This is sent to the driver for framebuffer overlay / HUD. */
    struct util_queue_monitoring stats;
 
+   /**
+    * Number of syncs per entry point name, only allocated when
+    * MESA_GLTHREAD_REPORT_SYNCS is set.  It's printed at context destruction.
+    */
+   struct hash_table *SyncCounts;
+
    /** Whether GLThread is enabled. */
    bool enabled;
    bool inside_begin_end;
@@ -232,6 +246,16 @@ struct glthread_state
    /** Number of uint64_t elements filled already. */
    unsigned used;
 
+   /**
+    * The number of uint64_t elements after which the batch is flushed,
+    * excluding the END marker.  It's adjusted between MARSHAL_MIN_BATCH_SIZE
+    * and MARSHAL_MAX_CMD_BUFFER_SIZE.
+    */
+   unsigned batch_limit;
+
+   /** Number of batches flushed because they were full since the last sync. */
+   unsigned num_full_batches;
+
    /** Upload buffer. */
    struct gl_buffer_object *upload_buffer;
    uint8_t *upload_ptr;
@@ -328,7 +352,7 @@ void _mesa_glthread_init_dispatch7(struct gl_context *ctx,
 void _mesa_glthread_enable(struct gl_context *ctx);
 void _mesa_glthread_disable(struct gl_context *ctx);
 void _mesa_glthread_flush_batch(struct gl_context *ctx);
-void _mesa_glthread_finish(struct gl_context *ctx);
+bool _mesa_glthread_finish(struct gl_context *ctx);
 void _mesa_glthread_finish_before(struct gl_context *ctx, const char *func);
 bool _mesa_glthread_invalidate_zsbuf(struct gl_context *ctx);
 void _mesa_glthread_release_upload_buffer(struct gl_context *ctx, bool async_release);
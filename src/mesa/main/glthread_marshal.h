@@ -98,8 +98,10 @@ _mesa_glthread_allocate_command(struct gl_context *ctx,
 
    assert (num_elements <= MARSHAL_MAX_CMD_SIZE / 8);
 
-   if (unlikely(glthread->used + num_elements > MARSHAL_MAX_CMD_SIZE / 8))
+   if (unlikely(glthread->used + num_elements > glthread->batch_limit)) {
+      glthread->num_full_batches++;
       _mesa_glthread_flush_batch(ctx);
+   }
 
    struct glthread_batch *next = glthread->next_batch;
    struct marshal_cmd_base *cmd_base =
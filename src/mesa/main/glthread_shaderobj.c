@@ -23,6 +23,8 @@
 
 #include "glthread_marshal.h"
 #include "dispatch.h"
+#include "shaderapi.h"
+#include "shaderobj.h"
 #include "uniforms.h"
 #include "api_exec_decl.h"
 
@@ -103,3 +105,83 @@ _mesa_marshal_GetUniformLocation(GLuint program, const GLchar *name)
    /* This is thread-safe. See the comment in _mesa_marshal_GetActiveUniform. */
    return _mesa_GetUniformLocation_impl(program, name, true);
 }
+
+uint32_t
+_mesa_unmarshal_GetAttribLocation(struct gl_context *ctx,
+                                  const struct marshal_cmd_GetAttribLocation *restrict cmd)
+{
+   UNREACHABLE("never executed");
+   return 0;
+}
+
+GLint GLAPIENTRY
+_mesa_marshal_GetAttribLocation(GLuint program, const GLchar *name)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   /* This will generate GL_INVALID_OPERATION, as it should. */
+   if (ctx->GLThread.inside_begin_end) {
+      _mesa_glthread_finish_before(ctx, "GetAttribLocation");
+      return CALL_GetAttribLocation(ctx->Dispatch.Current, (program, name));
+   }
+
+   wait_for_glLinkProgram(ctx);
+
+   /* This is thread-safe. See the comment in _mesa_marshal_GetActiveUniform. */
+   return _mesa_GetAttribLocation_impl(program, name, true);
+}
+
+uint32_t
+_mesa_unmarshal_GetProgramiv(struct gl_context *ctx,
+                             const struct marshal_cmd_GetProgramiv *restrict cmd)
+{
+   UNREACHABLE("never executed");
+   return 0;
+}
+
+/* Whether the query only returns state that is set by glLinkProgram,
+ * glProgramBinary, glValidateProgram or glDeleteProgram, and can't generate
+ * an error for a valid program.
+ */
+static bool
+is_program_query_thread_safe(GLenum pname)
+{
+   switch (pname) {
+   case GL_DELETE_STATUS:
+   case GL_LINK_STATUS:
+   case GL_VALIDATE_STATUS:
+   case GL_INFO_LOG_LENGTH:
+   case GL_ACTIVE_ATTRIBUTES:
+   case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH:
+   case GL_ACTIVE_UNIFORMS:
+   case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+      return true;
+   default:
+      return false;
+   }
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetProgramiv(GLuint program, GLenum pname, GLint *params)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   /* Applications typically check the link status and the info log length
+    * right after glLinkProgram, which would otherwise always sync.
+    */
+   if (!ctx->GLThread.inside_begin_end &&
+       is_program_query_thread_safe(pname)) {
+      wait_for_glLinkProgram(ctx);
+
+      /* Invalid names are handled by the synchronous path, which sets
+       * the error.
+       */
+      if (_mesa_lookup_shader_program(ctx, program)) {
+         _mesa_GetProgramiv(program, pname, params);
+         return;
+      }
+   }
+
+   _mesa_glthread_finish_before(ctx, "GetProgramiv");
+   CALL_GetProgramiv(ctx->Dispatch.Current, (program, pname, params));
+}
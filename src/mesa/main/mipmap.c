@@ -33,6 +33,7 @@
 #include "glformats.h"
 #include "mipmap.h"
 #include "mtypes.h"
+#include "shared.h"
 #include "teximage.h"
 #include "texobj.h"
 #include "texstore.h"
@@ -41,6 +42,7 @@
 #include "util/half_float.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_queue.h"
 
 #include "state_tracker/st_cb_texture.h"
 
@@ -634,6 +636,239 @@ _mesa_generate_mipmap_level(GLenum target,
 }
 
 
+/**
+ * Number of levels generated by each pass of
+ * _mesa_generate_mipmap_levels_2d() over bands of rows of its source level.
+ */
+#define MIPMAP_PASS_LEVELS 4
+
+/**
+ * Bands of rows of the source level are about this size, so that the rows
+ * of the levels generated from them stay in the cache.
+ */
+#define MIPMAP_BAND_BYTES (256 << 10)
+
+/**
+ * Source levels with at least this many bytes are split across threads.
+ */
+#define MIPMAP_THREADED_MIN_BYTES (2 << 20)
+#define MIPMAP_MAX_JOBS 8
+
+/**
+ * One pass of _mesa_generate_mipmap_levels_2d().  Index 0 of the level
+ * arrays is the source level of the pass, indices 1 to num_levels are the
+ * levels generated.
+ */
+struct mipmap_pass {
+   enum pipe_format format;
+   unsigned num_levels;
+   const GLint *widths, *heights;
+   const GLubyte *src;
+   GLint srcRowStride;
+   GLubyte **maps;
+   const GLint *rowStrides;
+   /* Where to also store the last level, for the next pass, or NULL. */
+   GLubyte *tail;
+   /* Rows of the source level per band, a multiple of 1 << num_levels. */
+   unsigned band_rows;
+};
+
+struct mipmap_job {
+   struct util_queue_fence fence;
+   const struct mipmap_pass *pass;
+   unsigned first_row, num_rows;
+   GLubyte *scratch;
+};
+
+static size_t
+mipmap_band_scratch_size(const struct mipmap_pass *pass)
+{
+   const unsigned bpt = util_format_get_blocksize(pass->format);
+   size_t size = 0;
+
+   for (unsigned j = 1; j <= pass->num_levels; j++)
+      size += (size_t)MAX2(pass->band_rows >> j, 1) * pass->widths[j] * bpt;
+   return size;
+}
+
+/**
+ * Generate the levels of a pass for the job's rows of the source level,
+ * one band at a time.  The rows of a band are downsampled through all the
+ * levels in the scratch memory, which is only written to the (possibly
+ * write-combined) destination mappings.
+ */
+static void
+mipmap_run_job(void *data, void *gdata, int thread_index)
+{
+   const struct mipmap_job *job = data;
+   const struct mipmap_pass *pass = job->pass;
+   const unsigned bpt = util_format_get_blocksize(pass->format);
+   const unsigned end_row = job->first_row + job->num_rows;
+
+   for (unsigned row0 = job->first_row; row0 < end_row;
+        row0 += pass->band_rows) {
+      const unsigned end0 = MIN2(row0 + pass->band_rows, end_row);
+      const bool last = end0 == (unsigned)pass->heights[0];
+      const GLubyte *src = pass->src + (size_t)row0 * pass->srcRowStride;
+      GLint srcStride = pass->srcRowStride;
+      unsigned srcFirst = row0;
+      GLubyte *scratch = job->scratch;
+
+      for (unsigned j = 1; j <= pass->num_levels; j++) {
+         const unsigned first = row0 >> j;
+         const unsigned end = last ? pass->heights[j] :
+                              MIN2(end0 >> j, (unsigned)pass->heights[j]);
+         const GLint dstStride = pass->widths[j] * bpt;
+         const bool two_rows = pass->heights[j - 1] > pass->heights[j];
+
+         if (first >= end)
+            break;
+
+         for (unsigned r = first; r < end; r++) {
+            const GLubyte *srcA =
+               src + (size_t)((two_rows ? r * 2 : r) - srcFirst) * srcStride;
+            GLubyte *dst = scratch + (size_t)(r - first) * dstStride;
+
+            do_row(pass->format, pass->widths[j - 1],
+                   srcA, two_rows ? srcA + srcStride : srcA,
+                   pass->widths[j], dst);
+            memcpy(pass->maps[j] + (size_t)r * pass->rowStrides[j], dst,
+                   dstStride);
+            if (j == pass->num_levels && pass->tail)
+               memcpy(pass->tail + (size_t)r * dstStride, dst, dstStride);
+         }
+
+         src = scratch;
+         srcStride = dstStride;
+         srcFirst = first;
+         scratch += (size_t)MAX2(pass->band_rows >> j, 1) * dstStride;
+      }
+   }
+}
+
+static bool
+generate_mipmap_pass(struct gl_context *ctx, const struct mipmap_pass *pass)
+{
+   struct mipmap_job jobs[MIPMAP_MAX_JOBS];
+   const unsigned height = pass->heights[0];
+   const size_t src_bytes = (size_t)pass->widths[0] *
+                            util_format_get_blocksize(pass->format) * height;
+   const unsigned num_bands = DIV_ROUND_UP(height, pass->band_rows);
+   struct util_queue *queue = NULL;
+   unsigned num_jobs = 1;
+
+   if (src_bytes >= MIPMAP_THREADED_MIN_BYTES)
+      queue = _mesa_get_shared_worker_queue(ctx);
+
+   /* Count the threads the queue can have, it only starts them once jobs
+    * are waiting.
+    */
+   if (queue) {
+      num_jobs = MIN3(num_bands, queue->max_threads + 1, MIPMAP_MAX_JOBS);
+      num_jobs = MAX2(num_jobs, 1);
+   }
+
+   const size_t scratch_size = mipmap_band_scratch_size(pass);
+   GLubyte *scratch = malloc(scratch_size * num_jobs);
+   if (!scratch)
+      return false;
+
+   const unsigned bands_per_job = DIV_ROUND_UP(num_bands, num_jobs);
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      const unsigned first_row =
+         MIN2(i * bands_per_job * pass->band_rows, height);
+
+      jobs[i].pass = pass;
+      jobs[i].first_row = first_row;
+      jobs[i].num_rows = MIN2(bands_per_job * pass->band_rows,
+                              height - first_row);
+      jobs[i].scratch = scratch + scratch_size * i;
+   }
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      util_queue_add_job(queue, &jobs[i], &jobs[i].fence,
+                         mipmap_run_job, NULL, 0);
+   }
+
+   mipmap_run_job(&jobs[0], NULL, 0);
+
+   for (unsigned i = 1; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   free(scratch);
+   return true;
+}
+
+
+/**
+ * Generate levels 1 to numLevels - 1 of a 2D image without border from
+ * level 0, with the same results as _mesa_generate_mipmap_level().
+ *
+ * Instead of downsampling a whole level at a time, bands of rows are
+ * downsampled through several levels while they are in the cache, and the
+ * bands of large images are split across threads.  maps[0] is only read
+ * and the other levels are only written.
+ *
+ * \return false if out of memory
+ */
+bool
+_mesa_generate_mipmap_levels_2d(struct gl_context *ctx,
+                                enum pipe_format format, unsigned numLevels,
+                                const GLint *widths, const GLint *heights,
+                                GLubyte **maps, const GLint *rowStrides)
+{
+   const unsigned bpt = util_format_get_blocksize(format);
+   const GLubyte *src = maps[0];
+   GLint srcRowStride = rowStrides[0];
+   GLubyte *tail = NULL;
+   bool success = true;
+
+   for (unsigned base = 0; base + 1 < numLevels && success;) {
+      struct mipmap_pass pass;
+
+      pass.format = format;
+      pass.num_levels = MIN2(numLevels - 1 - base, MIPMAP_PASS_LEVELS);
+      pass.widths = widths + base;
+      pass.heights = heights + base;
+      pass.src = src;
+      pass.srcRowStride = srcRowStride;
+      pass.maps = maps + base;
+      pass.rowStrides = rowStrides + base;
+      pass.tail = NULL;
+      pass.band_rows =
+         align(MAX2(MIPMAP_BAND_BYTES / (widths[base] * bpt), 1),
+               1 << pass.num_levels);
+
+      const unsigned last = base + pass.num_levels;
+
+      /* The next pass reads its source level from this copy rather than
+       * from the write-only mapping.
+       */
+      if (last + 1 < numLevels) {
+         pass.tail = malloc((size_t)widths[last] * bpt * heights[last]);
+         if (!pass.tail)
+            success = false;
+      }
+
+      if (success)
+         success = generate_mipmap_pass(ctx, &pass);
+
+      free(tail);
+      tail = pass.tail;
+      src = tail;
+      srcRowStride = widths[last] * bpt;
+      base = last;
+   }
+
+   free(tail);
+   return success;
+}
+
+
 /**
  * compute next (level+1) image size
  * \return GL_FALSE if no smaller size can be generated (eg. src is 1x1x1 size)
@@ -797,6 +1032,89 @@ _mesa_prepare_mipmap_levels(struct gl_context *ctx,
 }
 
 
+/**
+ * Generate the mipmaps of each slice of a 2D, cube map face or 2D array
+ * image with _mesa_generate_mipmap_levels_2d().  st/mesa only gets here
+ * for formats that util_gen_mipmap() can't render to.
+ *
+ * \return false if the texture isn't one of those
+ */
+static bool
+generate_mipmap_uncompressed_2d(struct gl_context *ctx, GLenum target,
+                                struct gl_texture_object *texObj,
+                                const struct gl_texture_image *srcImage,
+                                GLuint maxLevel)
+{
+   struct gl_texture_image *images[MAX_TEXTURE_LEVELS];
+   GLint widths[MAX_TEXTURE_LEVELS], heights[MAX_TEXTURE_LEVELS];
+   GLint rowStrides[MAX_TEXTURE_LEVELS];
+   GLubyte *maps[MAX_TEXTURE_LEVELS];
+   unsigned numLevels = 0;
+   bool success = true;
+
+   switch (target) {
+   case GL_TEXTURE_2D:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+   case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+   case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+   case GL_TEXTURE_2D_ARRAY_EXT:
+   case GL_TEXTURE_CUBE_MAP_ARRAY:
+      break;
+   default:
+      return false;
+   }
+
+   if (srcImage->Border)
+      return false;
+
+   for (GLuint level = texObj->Attrib.BaseLevel; level <= maxLevel; level++) {
+      struct gl_texture_image *image =
+         _mesa_select_tex_image(texObj, target, level);
+      if (!image)
+         break;
+
+      images[numLevels] = image;
+      widths[numLevels] = image->Width;
+      heights[numLevels] = image->Height;
+      numLevels++;
+   }
+
+   if (numLevels < 2)
+      return true;
+
+   for (GLuint slice = 0; slice < srcImage->Depth && success; slice++) {
+      unsigned mapped;
+
+      /* Each level is written once as a whole, so don't read it back. */
+      for (mapped = 0; mapped < numLevels; mapped++) {
+         st_MapTextureImage(ctx, images[mapped], slice,
+                            0, 0, widths[mapped], heights[mapped],
+                            mapped ? GL_MAP_WRITE_BIT |
+                                     GL_MAP_INVALIDATE_RANGE_BIT :
+                                     GL_MAP_READ_BIT,
+                            &maps[mapped], &rowStrides[mapped]);
+         if (!maps[mapped])
+            break;
+      }
+
+      success = mapped == numLevels &&
+                _mesa_generate_mipmap_levels_2d(ctx, srcImage->TexFormat,
+                                                numLevels, widths, heights,
+                                                maps, rowStrides);
+
+      while (mapped--)
+         st_UnmapTextureImage(ctx, images[mapped], slice);
+   }
+
+   if (!success)
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "mipmap generation");
+   return true;
+}
+
+
 static void
 generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
                              struct gl_texture_object *texObj,
@@ -805,6 +1123,10 @@ generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
 {
    GLuint level;
 
+   if (generate_mipmap_uncompressed_2d(ctx, target, texObj, srcImage,
+                                       maxLevel))
+      return;
+
    for (level = texObj->Attrib.BaseLevel; level < maxLevel; level++) {
       /* generate image[level+1] from image[level] */
       struct gl_texture_image *srcLvlImage, *dstImage;
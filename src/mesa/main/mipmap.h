@@ -27,6 +27,11 @@
 #define MIPMAP_H
 
 #include "util/glheader.h"
+#include "util/format/u_formats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 struct gl_context;
 struct gl_texture_object;
@@ -45,9 +50,19 @@ extern void
 _mesa_generate_mipmap(struct gl_context *ctx, GLenum target,
                       struct gl_texture_object *texObj);
 
+extern bool
+_mesa_generate_mipmap_levels_2d(struct gl_context *ctx,
+                                enum pipe_format format, unsigned numLevels,
+                                const GLint *widths, const GLint *heights,
+                                GLubyte **maps, const GLint *rowStrides);
+
 extern GLboolean
 _mesa_next_mipmap_level_size(GLenum target, GLint border,
                        GLint srcWidth, GLint srcHeight, GLint srcDepth,
                        GLint *dstWidth, GLint *dstHeight, GLint *dstDepth);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* MIPMAP_H */
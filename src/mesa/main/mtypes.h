@@ -81,6 +81,7 @@ struct gl_texture_object;
 struct gl_debug_state;
 struct gl_context;
 struct st_context;
+struct cso_context;
 struct gl_uniform_storage;
 struct prog_instruction;
 struct gl_program_parameter_list;
@@ -1646,6 +1647,20 @@ struct gl_vertex_array_object
 
    /** The index buffer (also known as the element array buffer in OpenGL). */
    struct gl_buffer_object *IndexBufferObj;
+
+   /**
+    * The vertex elements state that the state tracker last created for this
+    * VAO and what it was created for. Handle is cleared when any attribute
+    * format, binding, stride, divisor or enable changes.
+    */
+   struct {
+      void *Handle;
+      struct cso_context *Cso;
+      unsigned CsoEpoch;
+      GLbitfield InputsRead;
+      GLbitfield DualSlotInputs;
+      unsigned Count;
+   } VertexElements;
 };
 
 
@@ -2269,6 +2284,8 @@ struct gl_ati_fragment_shader_state
 #define GLSL_CACHE_INFO 0x100 /**< Print debug information about shader cache */
 #define GLSL_CACHE_FALLBACK 0x200 /**< Force shader cache fallback paths */
 #define GLSL_SOURCE 0x400 /**< Only dump GLSL */
+#define GLSL_SERIAL_LINK 0x800 /**< Link one stage at a time */
+#define GLSL_NO_STAGE_CACHE 0x1000 /**< Don't reuse compiled shader stages */
 
 
 /**
@@ -2433,6 +2450,15 @@ struct gl_shared_state
    GLuint TextureStateStamp;	        /**< state notification for shared tex */
    /*@}*/
 
+   /**
+    * \name Buffer contents notification for cached translated vertices.
+    */
+   /*@{*/
+   bool HasTranslatedVertices; /**< a context caches translated vertices */
+   GLuint BufferWriteStamp;   /**< incremented when any buffer is written */
+   bool HasExternalBuffers;   /**< pinned or imported memory was used */
+   /*@}*/
+
    /**
     * \name Vertex/geometry/fragment programs
     */
@@ -2500,6 +2526,22 @@ struct gl_shared_state
     */
    bool HasExternallySharedImages;
 
+   /**
+    * Worker threads for the per-stage parts of glLinkProgram, converting
+    * large texture uploads and generating mipmaps, created on first use.
+    * See _mesa_get_shared_worker_queue().
+    */
+   struct util_queue WorkerQueue;
+
+   /**
+    * Serialized pre-link NIR of the shader stages compiled so far, keyed by
+    * the BLAKE3 of their preprocessed source and compile state, and the
+    * total size of the entries.  Created on first use and protected by
+    * Mutex.  See shader_cache_read_stage().
+    */
+   struct hash_table *ShaderStageCache;
+   size_t ShaderStageCacheSize;
+
    /* Small display list storage */
    struct {
       union gl_dlist_node *ptr;
@@ -2886,6 +2928,10 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum16 ShadeModel;
+      GLfloat LineWidth;
+      GLfloat PointSize;
+      GLbitfield EnabledKnown;  /**< Caps with a known state in Enabled */
+      GLbitfield Enabled;
       bool UseLoopback;
       bool NeedsFlush;
    } Current;
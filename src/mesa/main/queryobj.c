@@ -477,9 +477,11 @@ store_query_result(struct gl_context *ctx, struct gl_query_object *q,
       index = 0;
    }
 
-   if (q->pq)
+   if (q->pq) {
+      st_buffer_written(ctx->st, buf->buffer);
       pipe->get_query_result_resource(pipe, q->pq, flags, result_type, index,
                                       buf->buffer, offset);
+   }
 }
 
 static struct gl_query_object **
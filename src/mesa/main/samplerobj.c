@@ -38,6 +38,7 @@
 #include "main/mtypes.h"
 #include "main/samplerobj.h"
 #include "main/texturebindless.h"
+#include "state_tracker/st_atom.h"
 #include "util/u_memory.h"
 #include "api_exec_decl.h"
 
@@ -307,12 +308,55 @@ _mesa_IsSampler(GLuint sampler)
    return _mesa_lookup_samplerobj(ctx, sampler) != NULL;
 }
 
+/**
+ * Whether replacing the sampler object bound to a unit only changes the
+ * gallium sampler states.  Texture completeness depends on the filters,
+ * sampler views depend on the sRGB decode mode and fixed-function fragment
+ * shaders depend on the compare mode.  Units without a sampler object use
+ * the sampler state of the texture object, which isn't known here.
+ */
+static bool
+is_sampler_state_only_change(const struct gl_sampler_object *old_samp,
+                             const struct gl_sampler_object *new_samp)
+{
+   return old_samp && new_samp &&
+          old_samp->Attrib.MinFilter == new_samp->Attrib.MinFilter &&
+          old_samp->Attrib.MagFilter == new_samp->Attrib.MagFilter &&
+          old_samp->Attrib.ReductionMode == new_samp->Attrib.ReductionMode &&
+          old_samp->Attrib.sRGBDecode == new_samp->Attrib.sRGBDecode &&
+          old_samp->Attrib.CompareMode == new_samp->Attrib.CompareMode;
+}
+
+/**
+ * Flag a sampler binding change.  If only the gallium sampler states are
+ * affected, don't invalidate the texture state and the sampler views.
+ */
+static void
+sampler_binding_changed(struct gl_context *ctx,
+                        const struct gl_sampler_object *old_samp,
+                        const struct gl_sampler_object *new_samp)
+{
+   if (is_sampler_state_only_change(old_samp, new_samp)) {
+      FLUSH_VERTICES(ctx, 0, GL_TEXTURE_BIT);
+      ST_SET_SHADER_STATES(ctx->NewDriverState, SAMPLERS);
+
+      /* The shader variants depend on GL_CLAMP being used, see
+       * update_sampler_gl_clamp.
+       */
+      if (old_samp->glclamp_mask != new_samp->glclamp_mask)
+         ST_SET_STATES(ctx->NewDriverState,
+                       ctx->DriverFlags.NewSamplersWithClamp);
+   } else {
+      FLUSH_VERTICES(ctx, _NEW_TEXTURE_OBJECT, GL_TEXTURE_BIT);
+   }
+}
+
 void
 _mesa_bind_sampler(struct gl_context *ctx, GLuint unit,
                    struct gl_sampler_object *sampObj)
 {
    if (ctx->Texture.Unit[unit].Sampler != sampObj) {
-      FLUSH_VERTICES(ctx, _NEW_TEXTURE_OBJECT, GL_TEXTURE_BIT);
+      sampler_binding_changed(ctx, ctx->Texture.Unit[unit].Sampler, sampObj);
    }
 
    _mesa_reference_sampler_object(ctx, &ctx->Texture.Unit[unit].Sampler,
@@ -425,11 +469,10 @@ bind_samplers(struct gl_context *ctx, GLuint first, GLsizei count,
 
          /* Bind the new sampler */
          if (sampObj != currentSampler) {
+            sampler_binding_changed(ctx, currentSampler, sampObj);
             _mesa_reference_sampler_object(ctx,
                                            &ctx->Texture.Unit[unit].Sampler,
                                            sampObj);
-            ctx->NewState |= _NEW_TEXTURE_OBJECT;
-            ctx->PopAttribState |= GL_TEXTURE_BIT;
          }
       }
 
@@ -536,6 +579,19 @@ flush(struct gl_context *ctx)
    FLUSH_VERTICES(ctx, _NEW_TEXTURE_OBJECT, GL_TEXTURE_BIT);
 }
 
+
+/**
+ * This is called just prior to changing sampler object state that is only
+ * used by the gallium sampler states, so that texture completeness and
+ * sampler views don't have to be revalidated.
+ */
+static inline void
+flush_sampler_state(struct gl_context *ctx)
+{
+   FLUSH_VERTICES(ctx, 0, GL_TEXTURE_BIT);
+   ST_SET_SHADER_STATES(ctx->NewDriverState, SAMPLERS);
+}
+
 #define INVALID_PARAM 0x100
 #define INVALID_PNAME 0x101
 #define INVALID_VALUE 0x102
@@ -547,7 +603,7 @@ set_sampler_wrap_s(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.WrapS == param)
       return GL_FALSE;
    if (validate_texture_wrap_mode(ctx, param)) {
-      flush(ctx);
+      flush_sampler_state(ctx);
       update_sampler_gl_clamp(ctx, samp, is_wrap_gl_clamp(samp->Attrib.WrapS), is_wrap_gl_clamp(param), WRAP_S);
       samp->Attrib.WrapS = param;
       samp->Attrib.state.wrap_s = wrap_to_gallium(param);
@@ -565,7 +621,7 @@ set_sampler_wrap_t(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.WrapT == param)
       return GL_FALSE;
    if (validate_texture_wrap_mode(ctx, param)) {
-      flush(ctx);
+      flush_sampler_state(ctx);
       update_sampler_gl_clamp(ctx, samp, is_wrap_gl_clamp(samp->Attrib.WrapT), is_wrap_gl_clamp(param), WRAP_T);
       samp->Attrib.WrapT = param;
       samp->Attrib.state.wrap_t = wrap_to_gallium(param);
@@ -583,7 +639,7 @@ set_sampler_wrap_r(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.WrapR == param)
       return GL_FALSE;
    if (validate_texture_wrap_mode(ctx, param)) {
-      flush(ctx);
+      flush_sampler_state(ctx);
       update_sampler_gl_clamp(ctx, samp, is_wrap_gl_clamp(samp->Attrib.WrapR), is_wrap_gl_clamp(param), WRAP_R);
       samp->Attrib.WrapR = param;
       samp->Attrib.state.wrap_r = wrap_to_gallium(param);
@@ -647,7 +703,7 @@ set_sampler_lod_bias(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.LodBias == param)
       return GL_FALSE;
 
-   flush(ctx);
+   flush_sampler_state(ctx);
    samp->Attrib.LodBias = param;
    samp->Attrib.state.lod_bias = util_quantize_lod_bias(param);
    return GL_TRUE;
@@ -659,7 +715,7 @@ set_sampler_border_colorf(struct gl_context *ctx,
                           struct gl_sampler_object *samp,
                           const GLfloat params[4])
 {
-   flush(ctx);
+   flush_sampler_state(ctx);
    memcpy(samp->Attrib.state.border_color.f, params, 4 * sizeof(float));
    _mesa_update_is_border_color_nonzero(samp);
    return GL_TRUE;
@@ -671,7 +727,7 @@ set_sampler_border_colori(struct gl_context *ctx,
                           struct gl_sampler_object *samp,
                           const GLint params[4])
 {
-   flush(ctx);
+   flush_sampler_state(ctx);
    memcpy(samp->Attrib.state.border_color.i, params, 4 * sizeof(float));
    _mesa_update_is_border_color_nonzero(samp);
    return GL_TRUE;
@@ -683,7 +739,7 @@ set_sampler_border_colorui(struct gl_context *ctx,
                            struct gl_sampler_object *samp,
                            const GLuint params[4])
 {
-   flush(ctx);
+   flush_sampler_state(ctx);
    memcpy(samp->Attrib.state.border_color.ui, params, 4 * sizeof(float));
    _mesa_update_is_border_color_nonzero(samp);
    return GL_TRUE;
@@ -697,7 +753,7 @@ set_sampler_min_lod(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.MinLod == param)
       return GL_FALSE;
 
-   flush(ctx);
+   flush_sampler_state(ctx);
    samp->Attrib.MinLod = param;
    samp->Attrib.state.min_lod = MAX2(param, 0.0f); /* only positive */
 
@@ -712,7 +768,7 @@ set_sampler_max_lod(struct gl_context *ctx, struct gl_sampler_object *samp,
    if (samp->Attrib.MaxLod == param)
       return GL_FALSE;
 
-   flush(ctx);
+   flush_sampler_state(ctx);
    samp->Attrib.MaxLod = param;
    samp->Attrib.state.max_lod = param;
    return GL_TRUE;
@@ -767,7 +823,7 @@ set_sampler_compare_func(struct gl_context *ctx,
    case GL_GREATER:
    case GL_ALWAYS:
    case GL_NEVER:
-      flush(ctx);
+      flush_sampler_state(ctx);
       samp->Attrib.CompareFunc = param;
       samp->Attrib.state.compare_func = func_to_gallium(param);
       return GL_TRUE;
@@ -790,7 +846,7 @@ set_sampler_max_anisotropy(struct gl_context *ctx,
    if (param < 1.0F)
       return INVALID_VALUE;
 
-   flush(ctx);
+   flush_sampler_state(ctx);
    /* clamp to max, that's what NVIDIA does */
    samp->Attrib.MaxAnisotropy = MIN2(param, ctx->Const.MaxTextureMaxAnisotropy);
    /* gallium sets 0 for 1 */
@@ -814,7 +870,7 @@ set_sampler_cube_map_seamless(struct gl_context *ctx,
    if (param != GL_TRUE && param != GL_FALSE)
       return INVALID_VALUE;
 
-   flush(ctx);
+   flush_sampler_state(ctx);
    samp->Attrib.CubeMapSeamless = param;
    samp->Attrib.state.seamless_cube_map = param;
    return GL_TRUE;
@@ -212,20 +212,22 @@ _mesa_GetActiveAttrib(GLuint program, GLuint desired_index,
                                   (GLint *) type, false, "glGetActiveAttrib");
 }
 
-GLint GLAPIENTRY
-_mesa_GetAttribLocation(GLuint program, const GLchar * name)
+GLint
+_mesa_GetAttribLocation_impl(GLuint program, const GLchar *name,
+                             bool glthread)
 {
    GET_CURRENT_CONTEXT(ctx);
    struct gl_shader_program *const shProg =
-      _mesa_lookup_shader_program_err(ctx, program, "glGetAttribLocation");
+      _mesa_lookup_shader_program_err_glthread(ctx, program, glthread,
+                                               "glGetAttribLocation");
 
    if (!shProg) {
       return -1;
    }
 
    if (!shProg->data->LinkStatus) {
-      _mesa_error(ctx, GL_INVALID_OPERATION,
-                  "glGetAttribLocation(program not linked)");
+      _mesa_error_glthread_safe(ctx, GL_INVALID_OPERATION, glthread,
+                                "glGetAttribLocation(program not linked)");
       return -1;
    }
 
@@ -248,6 +250,12 @@ _mesa_GetAttribLocation(GLuint program, const GLchar * name)
    return program_resource_location(res, array_index);
 }
 
+GLint GLAPIENTRY
+_mesa_GetAttribLocation(GLuint program, const GLchar * name)
+{
+   return _mesa_GetAttribLocation_impl(program, name, false);
+}
+
 unsigned
 _mesa_count_active_attribs(struct gl_shader_program *shProg)
 {
@@ -153,6 +153,10 @@ _mesa_get_shader_flags(void)
          flags |= GLSL_USE_PROG;
       if (strstr(env, "errors"))
          flags |= GLSL_REPORT_ERRORS;
+      if (strstr(env, "serial_link"))
+         flags |= GLSL_SERIAL_LINK;
+      if (strstr(env, "nostagecache"))
+         flags |= GLSL_NO_STAGE_CACHE;
    }
 
    return flags;
@@ -73,6 +73,10 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh);
 extern void
 _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *sh_prog);
 
+GLint
+_mesa_GetAttribLocation_impl(GLuint program, const GLchar *name,
+                             bool glthread);
+
 extern unsigned
 _mesa_count_active_attribs(struct gl_shader_program *shProg);
 
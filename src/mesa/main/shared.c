@@ -46,8 +46,10 @@
 
 #include "util/hash_table.h"
 #include "util/set.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_memory.h"
 #include "util/u_process.h"
+#include "util/u_queue.h"
 #include "util/u_threaded_context.h"
 #include "state_tracker/st_context.h"
 
@@ -325,6 +327,12 @@ delete_semaphore_object_cb(void *data, void *userData)
    _mesa_delete_semaphore_object(ctx, semObj);
 }
 
+static void
+free_stage_cache_entry(struct hash_entry *entry)
+{
+   free(entry->data);
+}
+
 /**
  * Deallocate a shared state object and all children structures.
  *
@@ -424,6 +432,11 @@ free_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
    assert(!shared->ReleaseResources.entries);
    _mesa_set_fini(&shared->ReleaseResources, NULL);
 
+   if (util_queue_is_initialized(&shared->WorkerQueue))
+      util_queue_destroy(&shared->WorkerQueue);
+   if (shared->ShaderStageCache)
+      _mesa_hash_table_destroy(shared->ShaderStageCache, free_stage_cache_entry);
+
    simple_mtx_destroy(&shared->Mutex);
    simple_mtx_destroy(&shared->TexMutex);
 
@@ -531,3 +544,37 @@ _mesa_release_pending_resource(struct gl_context *ctx, struct pipe_resource *res
    pipe_resource_release(ctx->pipe, resource);
    return true;
 }
+
+
+/* The calling thread always takes a part of the work, so this allows
+ * splitting it in up to 8 parts.
+ */
+#define SHARED_WORKER_MAX_THREADS 7
+
+/**
+ * Return the worker threads of the share group, created on first use, or
+ * NULL if there is only one CPU.  They split linking, large texture
+ * conversions and mipmap generation, with the calling thread processing
+ * one of the parts.
+ */
+struct util_queue *
+_mesa_get_shared_worker_queue(struct gl_context *ctx)
+{
+   struct gl_shared_state *shared = ctx->Shared;
+   unsigned num_threads = util_get_cpu_caps()->nr_cpus;
+
+   if (num_threads <= 1)
+      return NULL;
+
+   simple_mtx_lock(&shared->Mutex);
+   if (!util_queue_is_initialized(&shared->WorkerQueue)) {
+      util_queue_init(&shared->WorkerQueue, "gl_worker",
+                      SHARED_WORKER_MAX_THREADS + 1,
+                      MIN2(num_threads - 1, SHARED_WORKER_MAX_THREADS),
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+   }
+   simple_mtx_unlock(&shared->Mutex);
+
+   return util_queue_is_initialized(&shared->WorkerQueue) ?
+          &shared->WorkerQueue : NULL;
+}
@@ -25,7 +25,12 @@
 #ifndef SHARED_H
 #define SHARED_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
+struct util_queue;
 
 void
 _mesa_reference_shared_state(struct gl_context *ctx,
@@ -39,4 +44,12 @@ _mesa_alloc_shared_state(struct gl_context *ctx,
 
 bool
 _mesa_release_pending_resource(struct gl_context *ctx, struct pipe_resource *resource, bool frontend_released);
+
+struct util_queue *
+_mesa_get_shared_worker_queue(struct gl_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * SSE4.1 version of the ubyte swizzles that dominate glTexImage uploads
+ * with format conversion: RGB8 to RGBA8 and the BGRA/RGBA channel swaps.
+ */
+
+#include "main/sse_swizzle.h"
+#include "main/formats.h"
+#include "util/macros.h"
+#include <smmintrin.h>
+
+int
+_mesa_swizzle_ubyte_rgba_sse41(uint8_t *dst, const uint8_t *src,
+                               int num_src_channels, const uint8_t swizzle[4],
+                               uint8_t one, int count)
+{
+   alignas(16) uint8_t shuffle[16];
+   alignas(16) uint8_t constant[16];
+   int i = 0;
+
+   assert(num_src_channels == 3 || num_src_channels == 4);
+
+   /* Each iteration converts 4 pixels. Byte indices with the top bit set
+    * make pshufb write zeros, which are then ORed with the constants.
+    */
+   for (unsigned p = 0; p < 4; p++) {
+      for (unsigned c = 0; c < 4; c++) {
+         const uint8_t swz = swizzle[c];
+
+         if (swz < 4) {
+            assert(swz < num_src_channels);
+            shuffle[p * 4 + c] = p * num_src_channels + swz;
+            constant[p * 4 + c] = 0;
+         } else {
+            assert(swz == MESA_FORMAT_SWIZZLE_ZERO ||
+                   swz == MESA_FORMAT_SWIZZLE_ONE);
+            shuffle[p * 4 + c] = 0x80;
+            constant[p * 4 + c] = swz == MESA_FORMAT_SWIZZLE_ONE ? one : 0;
+         }
+      }
+   }
+
+   const __m128i shuf = _mm_load_si128((const __m128i *)shuffle);
+   const __m128i cnst = _mm_load_si128((const __m128i *)constant);
+
+   /* 4 RGB pixels are 12 bytes, but 16 bytes are loaded, so stop while at
+    * least 16 bytes are left in the source.
+    */
+   const int last = num_src_channels == 4 ? count - 4 : count - 6;
+
+   for (; i <= last; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * num_src_channels));
+      v = _mm_or_si128(_mm_shuffle_epi8(v, shuf), cnst);
+      _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+   }
+
+   return i;
+}
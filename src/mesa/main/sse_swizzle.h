@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef SSE_SWIZZLE_H
+#define SSE_SWIZZLE_H
+
+#include <stdint.h>
+
+/**
+ * Swizzle \p count 3 or 4-channel ubyte pixels into 4-channel ubyte pixels.
+ * Swizzle values must be channel indices, MESA_FORMAT_SWIZZLE_ZERO or
+ * MESA_FORMAT_SWIZZLE_ONE.
+ *
+ * \return the number of pixels converted, which can be lower than count.
+ *         The caller must convert the remaining pixels.
+ */
+int
+_mesa_swizzle_ubyte_rgba_sse41(uint8_t *dst, const uint8_t *src,
+                               int num_src_channels, const uint8_t swizzle[4],
+                               uint8_t one, int count);
+
+#endif /* SSE_SWIZZLE_H */
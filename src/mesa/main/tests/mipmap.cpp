@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "main/mipmap.h"
+#include "test_context.h"
+
+namespace {
+
+struct mipmap_chain {
+   std::vector<GLint> widths, heights, strides;
+   std::vector<std::vector<uint8_t>> levels;
+   std::vector<GLubyte *> maps;
+
+   /* Rows are padded by pad bytes to check the strides are honored. */
+   mipmap_chain(unsigned width, unsigned height, unsigned pad)
+   {
+      while (true) {
+         widths.push_back(width);
+         heights.push_back(height);
+         strides.push_back(width * 4 + pad);
+         levels.emplace_back((size_t)strides.back() * height, 0);
+         if (width == 1 && height == 1)
+            break;
+         width = MAX2(width / 2, 1);
+         height = MAX2(height / 2, 1);
+      }
+      for (auto &level : levels)
+         maps.push_back(level.data());
+   }
+};
+
+/* Box filter of _mesa_generate_mipmap_level() for RGBA8, which truncates
+ * the average and drops the last row or column of odd sizes.
+ */
+static void
+reference_level(const struct mipmap_chain *chain, unsigned level,
+                std::vector<uint8_t> *dst)
+{
+   const unsigned sw = chain->widths[level - 1];
+   const unsigned sh = chain->heights[level - 1];
+   const unsigned dw = chain->widths[level], dh = chain->heights[level];
+   const unsigned sstride = chain->strides[level - 1];
+   const uint8_t *src = chain->levels[level - 1].data();
+
+   dst->assign((size_t)dw * dh * 4, 0);
+   for (unsigned y = 0; y < dh; y++) {
+      const uint8_t *a = src + (size_t)(sh > dh ? y * 2 : y) * sstride;
+      const uint8_t *b = sh > dh ? a + sstride : a;
+
+      for (unsigned x = 0; x < dw; x++) {
+         for (unsigned c = 0; c < 4; c++) {
+            uint8_t *out = &(*dst)[((size_t)y * dw + x) * 4 + c];
+
+            if (sw > dw) {
+               *out = (a[x * 8 + c] + a[x * 8 + 4 + c] +
+                       b[x * 8 + c] + b[x * 8 + 4 + c]) / 4;
+            } else {
+               *out = (a[x * 4 + c] + b[x * 4 + c]) / 2;
+            }
+         }
+      }
+   }
+}
+
+static void
+check_levels(struct mesa_test_context *mc, unsigned width, unsigned height)
+{
+   struct mipmap_chain chain(width, height, 12);
+   std::vector<uint8_t> expected;
+
+   chain.levels[0] = random_bytes(chain.levels[0].size(), width * 31 + height);
+   chain.maps[0] = chain.levels[0].data();
+   ASSERT_TRUE(_mesa_generate_mipmap_levels_2d(mc->ctx,
+                                               PIPE_FORMAT_R8G8B8A8_UNORM,
+                                               chain.levels.size(),
+                                               chain.widths.data(),
+                                               chain.heights.data(),
+                                               chain.maps.data(),
+                                               chain.strides.data()));
+
+   for (unsigned level = 1; level < chain.levels.size(); level++) {
+      reference_level(&chain, level, &expected);
+      for (int y = 0; y < chain.heights[level]; y++) {
+         ASSERT_EQ(memcmp(chain.maps[level] + (size_t)y * chain.strides[level],
+                          &expected[(size_t)y * chain.widths[level] * 4],
+                          chain.widths[level] * 4), 0)
+            << width << "x" << height << " level " << level << " row " << y;
+      }
+   }
+}
+
+} /* namespace */
+
+TEST(mipmap, small_levels)
+{
+   mesa_test_context mc;
+
+   check_levels(&mc, 37, 23);
+   check_levels(&mc, 1, 300);
+   check_levels(&mc, 300, 1);
+   check_levels(&mc, 3, 700);
+}
+
+TEST(mipmap, large_levels)
+{
+   mesa_test_context mc;
+
+   /* Large enough to be split across threads, with odd heights in the
+    * middle of the chain and several passes.
+    */
+   check_levels(&mc, 2048, 1030);
+   check_levels(&mc, 1025, 2047);
+}
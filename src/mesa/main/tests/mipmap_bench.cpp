@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: MIT */
+
+/* Measures the generation of the mipmaps of a 4096x4096 RGBA8 image with
+ * different numbers of worker threads. Not run as part of the test suite.
+ *
+ * The worker queue of the share group is only created on machines with
+ * several CPUs, so run under taskset -c 0 for the single-threaded rate.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "main/mipmap.h"
+#include "test_context.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+
+static const unsigned size = 4096, iterations = 4;
+
+struct mipmap_bench_chain {
+   std::vector<GLint> widths, heights, strides;
+   std::vector<std::vector<uint8_t>> levels;
+   std::vector<GLubyte *> maps;
+
+   mipmap_bench_chain()
+   {
+      for (unsigned s = size; s >= 1; s /= 2) {
+         widths.push_back(s);
+         heights.push_back(s);
+         strides.push_back(s * 4);
+         levels.emplace_back((size_t)s * s * 4, 0);
+      }
+      levels[0] = random_bytes(levels[0].size(), 3);
+      for (auto &level : levels)
+         maps.push_back(level.data());
+   }
+};
+
+static void
+run(const char *name, struct mesa_test_context *mc,
+    struct mipmap_bench_chain *chain)
+{
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++) {
+      _mesa_generate_mipmap_levels_2d(mc->ctx, PIPE_FORMAT_R8G8B8A8_UNORM,
+                                      chain->levels.size(),
+                                      chain->widths.data(),
+                                      chain->heights.data(),
+                                      chain->maps.data(),
+                                      chain->strides.data());
+   }
+   int64_t elapsed = os_time_get_nano() - start;
+
+   printf("  %-24s %8.1f Mtexels/s of level 0\n", name,
+          (double)size * size * iterations * 1000.0 / elapsed);
+}
+
+int
+main(int argc, char **argv)
+{
+   const unsigned max_threads = util_get_cpu_caps()->nr_cpus - 1;
+   struct mipmap_bench_chain chain;
+   char label[64];
+
+   printf("rgba8 %ux%u mipmap chain:\n", size, size);
+
+   if (max_threads == 0) {
+      mesa_test_context mc;
+      run("no workers", &mc, &chain);
+   }
+
+   /* Set up the worker queue of the share group with as many threads. */
+   for (unsigned threads = 1; threads <= MIN2(max_threads, 7);
+        threads = threads * 2 + 1) {
+      mesa_test_context mc;
+
+      util_queue_init(&mc.shared->WorkerQueue, "gl_worker", threads + 1,
+                      threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+      snprintf(label, sizeof(label), "%u workers", threads);
+      run(label, &mc, &chain);
+   }
+   return 0;
+}
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef MESA_MAIN_TESTS_TEST_CONTEXT_H
+#define MESA_MAIN_TESTS_TEST_CONTEXT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "main/mtypes.h"
+#include "util/u_queue.h"
+
+/* A context with only the shared state used by the worker threads of
+ * texture uploads and mipmap generation set up.
+ */
+struct mesa_test_context {
+   struct gl_context *ctx;
+   struct gl_shared_state *shared;
+
+   mesa_test_context()
+   {
+      ctx = (struct gl_context *)calloc(1, sizeof(*ctx));
+      shared = (struct gl_shared_state *)calloc(1, sizeof(*shared));
+      simple_mtx_init(&shared->Mutex, mtx_plain);
+      ctx->Shared = shared;
+   }
+
+   ~mesa_test_context()
+   {
+      if (util_queue_is_initialized(&shared->WorkerQueue))
+         util_queue_destroy(&shared->WorkerQueue);
+      simple_mtx_destroy(&shared->Mutex);
+      free(shared);
+      free(ctx);
+   }
+};
+
+static inline std::vector<uint8_t>
+random_bytes(size_t size, uint32_t seed)
+{
+   std::vector<uint8_t> data(size);
+
+   for (size_t i = 0; i < size; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      data[i] = seed >> 24;
+   }
+   return data;
+}
+
+#endif /* MESA_MAIN_TESTS_TEST_CONTEXT_H */
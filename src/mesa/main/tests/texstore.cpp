@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "main/format_utils.h"
+#include "main/glformats.h"
+#include "main/texstore.h"
+#include "test_context.h"
+
+namespace {
+
+/* Only the state used by _mesa_texstore for color uploads without pixel
+ * transfer ops is set up.
+ */
+struct texstore_context : mesa_test_context {
+   struct gl_pixelstore_attrib packing;
+
+   texstore_context()
+   {
+      memset(&packing, 0, sizeof(packing));
+      packing.Alignment = 1;
+   }
+};
+
+/* Uploads a width x height x depth image and checks every texel against a
+ * scalar conversion.
+ */
+static void
+check_upload(struct texstore_context *tc, GLenum src_format,
+             unsigned src_comps, mesa_format dst_format, GLenum base_format,
+             unsigned width, unsigned height, unsigned depth)
+{
+   const unsigned row_stride = width * 4;
+   std::vector<uint8_t> src =
+      random_bytes((size_t)width * height * depth * src_comps, 1);
+   std::vector<uint8_t> dst((size_t)row_stride * height * depth, 0);
+   std::vector<GLubyte *> slices(depth);
+
+   for (unsigned i = 0; i < depth; i++)
+      slices[i] = dst.data() + (size_t)i * row_stride * height;
+
+   ASSERT_TRUE(_mesa_texstore(tc->ctx, depth > 1 ? 3 : 2, base_format,
+                              dst_format, row_stride, slices.data(),
+                              width, height, depth, src_format,
+                              GL_UNSIGNED_BYTE, src.data(), &tc->packing));
+
+   const bool bgra_dst = dst_format == MESA_FORMAT_B8G8R8A8_UNORM;
+
+   for (size_t i = 0; i < (size_t)width * height * depth; i++) {
+      const uint8_t *s = &src[i * src_comps];
+      uint8_t rgba[4] = { 0, 0, 0, 0xff };
+
+      if (src_format == GL_BGRA) {
+         rgba[0] = s[2];
+         rgba[1] = s[1];
+         rgba[2] = s[0];
+      } else {
+         rgba[0] = s[0];
+         rgba[1] = s[1];
+         rgba[2] = s[2];
+      }
+      if (src_comps == 4)
+         rgba[3] = s[3];
+
+      const uint8_t expected[4] = {
+         bgra_dst ? rgba[2] : rgba[0], rgba[1],
+         bgra_dst ? rgba[0] : rgba[2], rgba[3],
+      };
+      ASSERT_EQ(memcmp(&dst[i * 4], expected, 4), 0) << "texel " << i;
+   }
+}
+
+} /* namespace */
+
+TEST(texstore, rgb_to_rgba)
+{
+   texstore_context tc;
+
+   /* Odd widths exercise the scalar tail of the vectorized swizzle. */
+   check_upload(&tc, GL_RGB, 3, MESA_FORMAT_R8G8B8A8_UNORM, GL_RGBA,
+                37, 5, 1);
+   /* Large enough to be split into bands across threads. */
+   check_upload(&tc, GL_RGB, 3, MESA_FORMAT_R8G8B8A8_UNORM, GL_RGBA,
+                2047, 1031, 1);
+}
+
+TEST(texstore, bgra_swizzle)
+{
+   texstore_context tc;
+
+   check_upload(&tc, GL_BGRA, 4, MESA_FORMAT_R8G8B8A8_UNORM, GL_RGBA,
+                1025, 1030, 1);
+   check_upload(&tc, GL_RGBA, 4, MESA_FORMAT_B8G8R8A8_UNORM, GL_RGBA,
+                1025, 1030, 1);
+   check_upload(&tc, GL_RGB, 3, MESA_FORMAT_B8G8R8A8_UNORM, GL_RGBA,
+                1025, 1030, 1);
+}
+
+TEST(texstore, bands_span_slices)
+{
+   texstore_context tc;
+
+   /* Bands don't start at slice boundaries with this height. */
+   check_upload(&tc, GL_RGB, 3, MESA_FORMAT_R8G8B8A8_UNORM, GL_RGBA,
+                512, 333, 9);
+}
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MIT */
+
+/* Measures large ubyte texture uploads converted as one band and in bands
+ * on worker threads. Not run as part of the test suite.
+ *
+ * The swizzles use pshufb when the CPU has SSE4.1. Run with
+ * GALLIUM_OVERRIDE_CPU_CAPS=ssse3 to compare with the scalar swizzle.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "main/format_utils.h"
+#include "main/glformats.h"
+#include "main/texstore.h"
+#include "test_context.h"
+#include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+
+static const unsigned width = 4096, height = 4096, iterations = 4;
+
+/* A share group whose worker queue has num_threads threads. */
+struct texstore_bench_context : mesa_test_context {
+   struct gl_pixelstore_attrib packing;
+
+   texstore_bench_context(unsigned num_threads)
+   {
+      memset(&packing, 0, sizeof(packing));
+      packing.Alignment = 1;
+      util_queue_init(&shared->WorkerQueue, "gl_worker", num_threads + 1,
+                      num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+   }
+};
+
+static void
+report(const char *name, int64_t elapsed)
+{
+   printf("  %-28s %8.1f Mtexels/s\n", name,
+          (double)width * height * iterations * 1000.0 / elapsed);
+}
+
+static void
+run(const char *name, GLenum src_format, unsigned src_comps)
+{
+   std::vector<uint8_t> src =
+      random_bytes((size_t)width * height * src_comps, 2);
+   std::vector<uint8_t> dst((size_t)width * height * 4);
+   GLubyte *slice = dst.data();
+   const uint32_t src_mesa_format =
+      _mesa_format_from_format_and_type(src_format, GL_UNSIGNED_BYTE);
+
+   printf("%s, %ux%u:\n", name, width, height);
+
+   /* What each band of _mesa_texstore does, over the whole image. */
+   int64_t start = os_time_get_nano();
+   for (unsigned i = 0; i < iterations; i++) {
+      _mesa_format_convert(dst.data(), MESA_FORMAT_R8G8B8A8_UNORM, width * 4,
+                           src.data(), src_mesa_format, width * src_comps,
+                           width, height, NULL);
+   }
+   report("1 band", os_time_get_nano() - start);
+
+   const unsigned max_threads = util_get_cpu_caps()->nr_cpus - 1;
+
+   for (unsigned threads = 1; threads <= MIN2(max_threads, 7);
+        threads = threads * 2 + 1) {
+      texstore_bench_context tc(threads);
+      char label[64];
+
+      start = os_time_get_nano();
+      for (unsigned i = 0; i < iterations; i++) {
+         _mesa_texstore(tc.ctx, 2, GL_RGBA, MESA_FORMAT_R8G8B8A8_UNORM,
+                        width * 4, &slice, width, height, 1, src_format,
+                        GL_UNSIGNED_BYTE, src.data(), &tc.packing);
+      }
+      snprintf(label, sizeof(label), "%u bands", threads + 1);
+      report(label, os_time_get_nano() - start);
+   }
+}
+
+int
+main(int argc, char **argv)
+{
+   printf("sse4.1 swizzle: %s\n",
+          util_get_cpu_caps()->has_sse4_1 ? "yes" : "no");
+   run("rgb8 to rgba8", GL_RGB, 3);
+   run("bgra8 to rgba8", GL_BGRA, 4);
+   return 0;
+}
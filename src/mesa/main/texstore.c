@@ -73,8 +73,10 @@
 #include "enums.h"
 #include "glformats.h"
 #include "pixeltransfer.h"
+#include "shared.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_queue.h"
 
 #include "state_tracker/st_cb_texture.h"
 
@@ -675,6 +677,116 @@ texstore_compressed(TEXSTORE_PARAMS)
                            srcFormat, srcType, srcAddr, srcPacking);
 }
 
+/**
+ * Uploads with at least this many destination bytes are converted by
+ * multiple threads, in bands of at least half of that.
+ */
+#define TEXSTORE_THREADED_MIN_BYTES (4 << 20)
+#define TEXSTORE_MAX_BANDS 8
+
+/**
+ * A band of rows of a texstore_rgba conversion.  Rows are numbered across
+ * all slices, so a band can span several slices of a 3D image.
+ */
+struct texstore_band {
+   struct util_queue_fence fence;
+   mesa_format dstFormat;
+   GLint dstRowStride;
+   GLubyte **dstSlices;
+   const GLubyte *src;
+   uint32_t srcMesaFormat;
+   int srcRowStride;
+   GLint width, height;
+   uint8_t *rebaseSwizzle;
+   unsigned first_row, num_rows;
+};
+
+static void
+texstore_convert_band(void *data, void *gdata, int thread_index)
+{
+   struct texstore_band *band = data;
+   unsigned row = band->first_row;
+   const unsigned end = band->first_row + band->num_rows;
+
+   while (row < end) {
+      const unsigned img = row / band->height;
+      const unsigned y = row % band->height;
+      const unsigned n = MIN2(band->height - y, end - row);
+
+      _mesa_format_convert(band->dstSlices[img] +
+                           (size_t)y * band->dstRowStride,
+                           band->dstFormat, band->dstRowStride,
+                           (void *)(band->src +
+                                    (size_t)row * band->srcRowStride),
+                           band->srcMesaFormat, band->srcRowStride,
+                           band->width, n, band->rebaseSwizzle);
+      row += n;
+   }
+}
+
+/**
+ * Convert all slices of an image with _mesa_format_convert.  Large images
+ * are split into bands of rows that are converted in parallel.
+ */
+static void
+texstore_convert(struct gl_context *ctx, mesa_format dstFormat,
+                 GLint dstRowStride, GLubyte **dstSlices,
+                 const GLubyte *src, uint32_t srcMesaFormat, int srcRowStride,
+                 GLint srcWidth, GLint srcHeight, GLint srcDepth,
+                 uint8_t *rebaseSwizzle)
+{
+   struct texstore_band bands[TEXSTORE_MAX_BANDS];
+   const unsigned total_rows = srcHeight * srcDepth;
+   const size_t row_bytes =
+      (size_t)srcWidth * _mesa_get_format_bytes(dstFormat);
+   const size_t total_bytes = row_bytes * total_rows;
+   struct util_queue *queue = NULL;
+   unsigned num_bands = 1;
+
+   if (total_bytes >= TEXSTORE_THREADED_MIN_BYTES)
+      queue = _mesa_get_shared_worker_queue(ctx);
+
+   /* The queue only starts more threads once jobs are waiting, so count
+    * the threads it can have rather than the ones it has.
+    */
+   if (queue) {
+      num_bands = MIN3(total_bytes / (TEXSTORE_THREADED_MIN_BYTES / 2),
+                       queue->max_threads + 1, TEXSTORE_MAX_BANDS);
+      num_bands = MIN2(num_bands, total_rows);
+   }
+
+   const unsigned rows_per_band = DIV_ROUND_UP(total_rows, num_bands);
+
+   for (unsigned i = 0; i < num_bands; i++) {
+      struct texstore_band *band = &bands[i];
+
+      band->dstFormat = dstFormat;
+      band->dstRowStride = dstRowStride;
+      band->dstSlices = dstSlices;
+      band->src = src;
+      band->srcMesaFormat = srcMesaFormat;
+      band->srcRowStride = srcRowStride;
+      band->width = srcWidth;
+      band->height = srcHeight;
+      band->rebaseSwizzle = rebaseSwizzle;
+      band->first_row = MIN2(i * rows_per_band, total_rows);
+      band->num_rows = MIN2(rows_per_band, total_rows - band->first_row);
+   }
+
+   for (unsigned i = 1; i < num_bands; i++) {
+      util_queue_fence_init(&bands[i].fence);
+      util_queue_add_job(queue, &bands[i], &bands[i].fence,
+                         texstore_convert_band, NULL, 0);
+   }
+
+   texstore_convert_band(&bands[0], NULL, 0);
+
+   for (unsigned i = 1; i < num_bands; i++) {
+      util_queue_fence_wait(&bands[i].fence);
+      util_queue_fence_destroy(&bands[i].fence);
+   }
+}
+
 static GLboolean
 texstore_rgba(TEXSTORE_PARAMS)
 {
@@ -814,13 +926,10 @@ texstore_rgba(TEXSTORE_PARAMS)
       needRebase = false;
    }
 
-   for (img = 0; img < srcDepth; img++) {
-      _mesa_format_convert(dstSlices[img], dstFormat, dstRowStride,
-                           src, srcMesaFormat, srcRowStride,
-                           srcWidth, srcHeight,
-                           needRebase ? rebaseSwizzle : NULL);
-      src += (size_t)srcHeight * srcRowStride;
-   }
+   texstore_convert(ctx, dstFormat, dstRowStride, dstSlices,
+                    src, srcMesaFormat, srcRowStride,
+                    srcWidth, srcHeight, srcDepth,
+                    needRebase ? rebaseSwizzle : NULL);
 
    free(tempImage);
    free(tempRGBA);
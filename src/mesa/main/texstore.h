@@ -40,9 +40,14 @@
 #include "formats.h"
 #include "util/macros.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct gl_context;
 struct gl_pixelstore_attrib;
 struct gl_texture_image;
+struct util_queue;
 
 /**
  * This macro defines the (many) parameters to the texstore functions.
@@ -145,4 +150,8 @@ _mesa_compute_compressed_pixelstore(GLuint dims, mesa_format texFormat,
                                     struct compressed_pixelstore *store);
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
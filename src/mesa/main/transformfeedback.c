@@ -50,6 +50,7 @@
 #include "api_exec_decl.h"
 
 #include "cso_cache/cso_context.h"
+#include "state_tracker/st_context.h"
 struct using_program_tuple
 {
    struct gl_program *prog;
@@ -479,6 +480,21 @@ _mesa_BeginTransformFeedback(GLenum mode)
 }
 
 
+/**
+ * The stream output buffers have been written, drop vertices translated
+ * from them.
+ */
+static void
+stream_output_buffers_written(struct gl_context *ctx,
+                              struct gl_transform_feedback_object *obj)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(obj->Buffers); i++) {
+      if (obj->Buffers[i] && obj->Buffers[i]->buffer)
+         st_buffer_written(ctx->st, obj->Buffers[i]->buffer);
+   }
+}
+
+
 static void
 end_transform_feedback(struct gl_context *ctx,
                        struct gl_transform_feedback_object *obj)
@@ -487,6 +503,7 @@ end_transform_feedback(struct gl_context *ctx,
    FLUSH_VERTICES(ctx, 0, 0);
 
    cso_set_stream_outputs(ctx->cso_context, 0, NULL, NULL, 0);
+   stream_output_buffers_written(ctx, obj);
 
    /* The next call to glDrawTransformFeedbackStream should use the vertex
     * count from the last call to glEndTransformFeedback.
@@ -1249,6 +1266,7 @@ pause_transform_feedback(struct gl_context *ctx,
    FLUSH_VERTICES(ctx, 0, 0);
 
    cso_set_stream_outputs(ctx->cso_context, 0, NULL, NULL, 0);
+   stream_output_buffers_written(ctx, obj);
 
    obj->Paused = GL_TRUE;
    _mesa_update_valid_to_render_state(ctx);
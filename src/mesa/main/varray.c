@@ -234,6 +234,7 @@ _mesa_vertex_attrib_binding(struct gl_context *ctx,
       vao->BufferBinding[bindingIndex]._BoundArrays |= array_bit;
 
       array->BufferBindingIndex = bindingIndex;
+      _mesa_vao_invalidate_vertex_elements(vao);
 
       if (vao->Enabled & array_bit) {
          ST_SET_STATE(ctx->NewDriverState, ST_NEW_VERTEX_ARRAYS);
@@ -294,6 +295,8 @@ _mesa_bind_vertex_buffer(struct gl_context *ctx,
 
       binding->Offset = offset;
       binding->Stride = stride;
+      if (stride_changed)
+         _mesa_vao_invalidate_vertex_elements(vao);
 
       if (!vbo) {
          vao->VertexAttribBufferMask &= ~binding->_BoundArrays;
@@ -338,6 +341,7 @@ vertex_binding_divisor(struct gl_context *ctx,
 
    if (binding->InstanceDivisor != divisor) {
       binding->InstanceDivisor = divisor;
+      _mesa_vao_invalidate_vertex_elements(vao);
 
       if (divisor)
          vao->NonZeroDivisorMask |= binding->_BoundArrays;
@@ -855,6 +859,7 @@ _mesa_update_array_format(struct gl_context *ctx,
    array->Format.User = new_format;
    recompute_vertex_format_fields(&array->Format, size, type, format,
                                   normalized, integer, doubles);
+   _mesa_vao_invalidate_vertex_elements(vao);
 
    if (vao->Enabled & VERT_BIT(attrib)) {
       ST_SET_STATE(ctx->NewDriverState, ST_NEW_VERTEX_ARRAYS);
@@ -2156,6 +2161,7 @@ _mesa_enable_vertex_array_attribs(struct gl_context *ctx,
       /* was disabled, now being enabled */
       vao->Enabled |= attrib_bits;
       vao->NonDefaultStateMask |= attrib_bits;
+      _mesa_vao_invalidate_vertex_elements(vao);
       ST_SET_STATE(ctx->NewDriverState, ST_NEW_VERTEX_ARRAYS);
       ctx->Array.NewVertexElements = true;
 
@@ -2259,6 +2265,7 @@ _mesa_disable_vertex_array_attribs(struct gl_context *ctx,
    if (attrib_bits) {
       /* was enabled, now being disabled */
       vao->Enabled &= ~attrib_bits;
+      _mesa_vao_invalidate_vertex_elements(vao);
       ST_SET_STATE(ctx->NewDriverState, ST_NEW_VERTEX_ARRAYS);
       ctx->Array.NewVertexElements = true;
 
@@ -172,6 +172,18 @@ _mesa_symbol_table_find_symbol(struct _mesa_symbol_table *table,
 }
 
 
+void *
+_mesa_symbol_table_find_symbol_pre_hashed(struct _mesa_symbol_table *table,
+                                          uint32_t hash, const char *name)
+{
+   struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(table->ht, hash, name);
+   struct symbol *const sym = entry ? (struct symbol *) entry->data : NULL;
+
+   return sym ? sym->data : NULL;
+}
+
+
 int
 _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
                               const char *name, void *declaration)
@@ -23,6 +23,8 @@
 #ifndef MESA_SYMBOL_TABLE_H
 #define MESA_SYMBOL_TABLE_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -46,6 +48,13 @@ extern int _mesa_symbol_table_symbol_scope(struct _mesa_symbol_table *table,
 extern void *_mesa_symbol_table_find_symbol(struct _mesa_symbol_table *symtab,
                                             const char *name);
 
+/* Like _mesa_symbol_table_find_symbol() for a name whose _mesa_hash_string()
+ * is already known.
+ */
+extern void *
+_mesa_symbol_table_find_symbol_pre_hashed(struct _mesa_symbol_table *symtab,
+                                          uint32_t hash, const char *name);
+
 extern struct _mesa_symbol_table *_mesa_symbol_table_ctor(void);
 
 extern void _mesa_symbol_table_dtor(struct _mesa_symbol_table *);
@@ -449,13 +449,44 @@ st_update_array_templ(struct st_context *st,
       vbuffer = vbuffer_local;
    }
 
+   struct gl_vertex_array_object *vao = ctx->Array._DrawVAO;
+   struct cso_context *cso = st->cso_context;
+   const unsigned velems_count =
+      vp->num_inputs + vp_variant->key.passthrough_edgeflags;
+
+   /* When all vertex elements come from the VAO, they only depend on the VAO
+    * and the vertex shader inputs, so the vertex elements state can be kept
+    * in the VAO. This avoids rebuilding and hashing it when an application
+    * switches between many VAOs. Shared display list VAOs are excluded
+    * because they can be used by multiple contexts at the same time.
+    */
+   const bool use_velems_cache = FILL_TC_SET_VB && UPDATE_VELEMS &&
+                                 !ALLOW_ZERO_STRIDE_ATTRIBS &&
+                                 !vao->SharedAndImmutable;
+   const bool velems_cached =
+      use_velems_cache &&
+      vao->VertexElements.Handle &&
+      vao->VertexElements.Cso == cso &&
+      vao->VertexElements.CsoEpoch == cso->velems_epoch &&
+      vao->VertexElements.InputsRead == inputs_read &&
+      vao->VertexElements.DualSlotInputs == dual_slot_inputs &&
+      vao->VertexElements.Count == velems_count;
+
    /* ST_NEW_VERTEX_ARRAYS */
    /* Setup arrays */
-   setup_arrays<POPCNT, FILL_TC_SET_VB, USE_VAO_FAST_PATH,
-                ALLOW_ZERO_STRIDE_ATTRIBS, HAS_IDENTITY_ATTRIB_MAPPING,
-                ALLOW_USER_BUFFERS, UPDATE_VELEMS>
-      (ctx, ctx->Array._DrawVAO, dual_slot_inputs, inputs_read,
-       inputs_read & enabled_arrays, &velements, vbuffer, &num_vbuffers);
+   if (velems_cached) {
+      setup_arrays<POPCNT, FILL_TC_SET_VB, USE_VAO_FAST_PATH,
+                   ALLOW_ZERO_STRIDE_ATTRIBS, HAS_IDENTITY_ATTRIB_MAPPING,
+                   ALLOW_USER_BUFFERS, UPDATE_VELEMS_OFF>
+         (ctx, vao, dual_slot_inputs, inputs_read,
+          inputs_read & enabled_arrays, &velements, vbuffer, &num_vbuffers);
+   } else {
+      setup_arrays<POPCNT, FILL_TC_SET_VB, USE_VAO_FAST_PATH,
+                   ALLOW_ZERO_STRIDE_ATTRIBS, HAS_IDENTITY_ATTRIB_MAPPING,
+                   ALLOW_USER_BUFFERS, UPDATE_VELEMS>
+         (ctx, vao, dual_slot_inputs, inputs_read,
+          inputs_read & enabled_arrays, &velements, vbuffer, &num_vbuffers);
+   }
 
    /* _NEW_CURRENT_ATTRIB */
    /* Setup zero-stride attribs. */
@@ -471,11 +502,25 @@ st_update_array_templ(struct st_context *st,
          assert(num_vbuffers == num_vbuffers_tc);
 
    if (UPDATE_VELEMS) {
-      struct cso_context *cso = st->cso_context;
-      velements.count = vp->num_inputs + vp_variant->key.passthrough_edgeflags;
+      velements.count = velems_count;
 
       /* Set vertex buffers and elements. */
-      if (FILL_TC_SET_VB) {
+      if (use_velems_cache) {
+         if (!velems_cached) {
+            vao->VertexElements.Handle =
+               cso_get_vertex_elements_handle(cso, &velements);
+            vao->VertexElements.Cso = cso;
+            vao->VertexElements.CsoEpoch = cso->velems_epoch;
+            vao->VertexElements.InputsRead = inputs_read;
+            vao->VertexElements.DualSlotInputs = dual_slot_inputs;
+            vao->VertexElements.Count = velems_count;
+         }
+
+         void *state =
+            cso_get_vertex_elements_handle_for_bind(cso,
+                                                    vao->VertexElements.Handle);
+         tc_set_vertex_elements_for_call(st->pipe, vbuffer, state);
+      } else if (FILL_TC_SET_VB) {
          void *state = cso_get_vertex_elements_for_bind(cso, &velements);
          tc_set_vertex_elements_for_call(st->pipe, vbuffer, state);
       } else {
@@ -488,7 +533,7 @@ st_update_array_templ(struct st_context *st,
    } else {
       /* Only vertex buffers. */
       if (!FILL_TC_SET_VB)
-         cso_set_vertex_buffers(st->cso_context, num_vbuffers, vbuffer);
+         cso_set_vertex_buffers(cso, num_vbuffers, vbuffer);
 
       /* This can change only when we update vertex elements. */
       assert(st->uses_user_vertex_buffers == uses_user_vertex_buffers);
@@ -438,6 +438,9 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    if (rb == NULL)
       return;
 
+   if (pack->BufferObj && pack->BufferObj->buffer)
+      st_buffer_written(st, pack->BufferObj->buffer);
+
    /* Validate state (to be sure we have up-to-date framebuffer surfaces)
     * and flush the bitmap cache prior to reading. */
    ST_PIPELINE_UPDATE_FB_STATE_MASK(mask);
@@ -2685,6 +2685,10 @@ st_GetTexSubImage(struct gl_context * ctx,
           texImage->TexFormat != MESA_FORMAT_ETC1_RGB8);
 
    st_flush_bitmap_cache(st);
+
+   if (ctx->Pack.BufferObj && ctx->Pack.BufferObj->buffer)
+      st_buffer_written(st, ctx->Pack.BufferObj->buffer);
+
    if (st->force_compute_based_texture_transfer)
       goto non_blit_transfer;
 
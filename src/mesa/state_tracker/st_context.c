@@ -61,6 +61,7 @@
 #include "st_texture.h"
 #include "st_util.h"
 #include "pipe/p_context.h"
+#include "util/u_atomic.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
@@ -365,6 +366,11 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
 
    cso_destroy_context(st->cso_context);
 
+   if (st->atom_stats) {
+      st_print_atom_stats(st);
+      FREE(st->atom_stats);
+   }
+
    if (st->pipe && destroy_pipe)
       st->pipe->destroy(st->pipe);
 
@@ -489,11 +495,17 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
 
    st->cso_context = cso_create_context(pipe, cso_flags);
    ctx->cso_context = st->cso_context;
+   if (cso_enable_translated_vertex_cache(st->cso_context))
+      p_atomic_set(&ctx->Shared->HasTranslatedVertices, true);
+   st->buffer_write_stamp = p_atomic_read(&ctx->Shared->BufferWriteStamp);
 
 #define ST_STATE(FLAG, st_update) st->update_functions[FLAG] = st_update;
 #include "st_atom_list.h"
 #undef ST_STATE
 
+   if (ST_DEBUG & DEBUG_ATOMS)
+      st->atom_stats = CALLOC(ST_NUM_ATOMS, sizeof(*st->atom_stats));
+
    st_init_clear(st);
    {
       enum pipe_texture_transfer_mode val = screen->caps.texture_transfer_modes;
@@ -870,6 +882,42 @@ st_add_releasebuf(struct st_context *st, struct pipe_resource *releasebuf)
    st->release_counter = st->work_counter;
 }
 
+/**
+ * Called when the contents of \p buffer change, or with NULL if any buffer
+ * may have changed. This drops vertices translated from it by u_vbuf.
+ */
+void
+st_buffer_written(struct st_context *st, struct pipe_resource *buffer)
+{
+   /* No context sharing the buffers uses u_vbuf. */
+   if (!p_atomic_read(&st->ctx->Shared->HasTranslatedVertices))
+      return;
+
+   unsigned stamp = p_atomic_inc_return(&st->ctx->Shared->BufferWriteStamp);
+
+   /* If another context has written a buffer since the last check, we don't
+    * know which one.
+    */
+   if (stamp != st->buffer_write_stamp + 1)
+      buffer = NULL;
+
+   cso_invalidate_translated_vertex_buffers(st->cso_context, buffer);
+   st->buffer_write_stamp = stamp;
+}
+
+/**
+ * Drop all translated vertices if buffers have been written by another
+ * context or can be written without notice.
+ */
+void
+st_sync_buffer_writes(struct st_context *st)
+{
+   struct gl_shared_state *shared = st->ctx->Shared;
+
+   cso_invalidate_translated_vertex_buffers(st->cso_context, NULL);
+   st->buffer_write_stamp = p_atomic_read(&shared->BufferWriteStamp);
+}
+
 void
 st_destroy_context(struct st_context *st)
 {
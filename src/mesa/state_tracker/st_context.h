@@ -131,6 +131,9 @@ struct st_context
    /* The list of state update functions. */
    st_update_func_t update_functions[ST_NUM_ATOMS];
 
+   /* Per-atom statistics, only allocated with ST_DEBUG=atoms. */
+   struct st_atom_stats *atom_stats;
+
    struct pipe_frontend_screen *frontend_screen; /* e.g. dri_screen */
    void *frontend_context; /* e.g. dri_context */
 
@@ -176,6 +179,9 @@ struct st_context
    bool draw_needs_minmax_index;
    bool is_threaded_context;
 
+   /* Last gl_shared_state::BufferWriteStamp seen by this context. */
+   unsigned buffer_write_stamp;
+
    /* driver supports scissored clears */
    bool can_scissor_clear;
 
@@ -519,6 +525,12 @@ st_prune_releasebufs(struct st_context *st);
 void
 st_add_releasebuf(struct st_context *st, struct pipe_resource *releasebuf);
 
+void
+st_buffer_written(struct st_context *st, struct pipe_resource *buffer);
+
+void
+st_sync_buffer_writes(struct st_context *st);
+
 #ifdef __cplusplus
 }
 #endif
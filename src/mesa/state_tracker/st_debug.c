@@ -26,6 +26,8 @@
  **************************************************************************/
 
 
+#include <inttypes.h>
+
 #include "main/context.h"
 #include "main/debug_output.h"
 #include "program/prog_print.h"
@@ -34,6 +36,7 @@
 #include "pipe/p_shader_tokens.h"
 
 #include "cso_cache/cso_cache.h"
+#include "util/os_time.h"
 
 #include "st_context.h"
 #include "st_debug.h"
@@ -53,6 +56,7 @@ static const struct debug_named_value st_debug_flags[] = {
    { "gremedy",  DEBUG_GREMEDY, "Enable GREMEDY debug extensions" },
    { "noreadpixcache", DEBUG_NOREADPIXCACHE, NULL },
    { "xfb",      DEBUG_PRINT_XFB, NULL },
+   { "atoms",    DEBUG_ATOMS, "Print the invocation count and CPU time of each state atom at context destruction" },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -64,3 +68,66 @@ st_debug_init(void)
 {
    ST_DEBUG = debug_get_option_st_debug();
 }
+
+
+static const char *st_atom_names[] = {
+#define ST_STATE(FLAG, st_update) #st_update,
+#include "st_atom_list.h"
+#undef ST_STATE
+};
+
+
+/**
+ * Same as the loop in st_validate_state, but record how many times each
+ * atom is executed and how long it takes.
+ */
+void
+st_update_states_profiled(struct st_context *st, const st_state_bitset dirty)
+{
+   unsigned i;
+
+   BITSET_FOREACH_SET(i, dirty, ST_NUM_ATOMS) {
+      int64_t start = os_time_get_nano();
+
+      st->update_functions[i](st);
+
+      st->atom_stats[i].count++;
+      st->atom_stats[i].time_ns += os_time_get_nano() - start;
+   }
+}
+
+
+/**
+ * Print the atoms that have been executed, most expensive first.
+ */
+void
+st_print_atom_stats(struct st_context *st)
+{
+   unsigned order[ST_NUM_ATOMS];
+   unsigned num = 0;
+   uint64_t total_ns = 0;
+
+   for (unsigned i = 0; i < ST_NUM_ATOMS; i++) {
+      if (!st->atom_stats[i].count)
+         continue;
+
+      /* Insertion sort by decreasing time. */
+      unsigned j = num++;
+      for (; j > 0 && st->atom_stats[order[j - 1]].time_ns <
+                      st->atom_stats[i].time_ns; j--)
+         order[j] = order[j - 1];
+      order[j] = i;
+      total_ns += st->atom_stats[i].time_ns;
+   }
+
+   debug_printf("st: state atoms, %.3f ms in total:\n", total_ns / 1e6);
+   debug_printf("st: %12s %10s %8s  %s\n", "invocations", "ms", "ns/call",
+                "atom");
+   for (unsigned i = 0; i < num; i++) {
+      const struct st_atom_stats *stats = &st->atom_stats[order[i]];
+
+      debug_printf("st: %12" PRIu64 " %10.3f %8" PRIu64 "  %s\n",
+                   stats->count, stats->time_ns / 1e6,
+                   stats->time_ns / stats->count, st_atom_names[order[i]]);
+   }
+}
@@ -31,6 +31,11 @@
 
 #include "util/compiler.h"
 #include "util/u_debug.h"
+#include "state_tracker/st_atom.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 struct st_context;
 
@@ -42,11 +47,24 @@ struct st_context;
 #define DEBUG_GREMEDY         BITFIELD_BIT(5)
 #define DEBUG_NOREADPIXCACHE  BITFIELD_BIT(6)
 #define DEBUG_PRINT_XFB       BITFIELD_BIT(7)
+#define DEBUG_ATOMS           BITFIELD_BIT(8)
 
 extern int ST_DEBUG;
 
 void st_debug_init( void );
 
+/** Per-atom statistics collected with ST_DEBUG=atoms. */
+struct st_atom_stats {
+   uint64_t count;
+   uint64_t time_ns;
+};
+
+void
+st_update_states_profiled(struct st_context *st, const st_state_bitset dirty);
+
+void
+st_print_atom_stats(struct st_context *st);
+
 static inline void
 ST_DBG( unsigned flag, const char *fmt, ... )
 {
@@ -60,5 +78,8 @@ ST_DBG( unsigned flag, const char *fmt, ... )
     }
 }
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* ST_DEBUG_H */
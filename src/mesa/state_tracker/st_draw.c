@@ -55,6 +55,7 @@
 
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/format/u_format.h"
 #include "util/u_prim.h"
@@ -84,6 +85,11 @@ st_prepare_draw(struct gl_context *ctx, const st_state_bitset state_mask)
 
    st_invalidate_readpix_cache(st);
 
+   if (unlikely(p_atomic_read(&ctx->Shared->BufferWriteStamp) !=
+                st->buffer_write_stamp ||
+                ctx->Shared->HasExternalBuffers))
+      st_sync_buffer_writes(st);
+
    /* Validate state. */
    st_validate_state(st, state_mask);
    st_context_add_work(st);
@@ -229,15 +229,15 @@ filter_double_subgroup(const nir_intrinsic_instr *intr, UNUSED const void *data)
    }
 }
 
-/* Second third of converting glsl_to_nir. This creates uniforms, gathers
- * info on varyings, etc after NIR link time opts have been applied.
+/* Second third of converting glsl_to_nir, first part. This creates the
+ * uniform parameters and associates them with the program's uniform storage,
+ * which is shared by all stages.
  */
 static void
-st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
-                         struct gl_shader_program *shader_program)
+st_glsl_to_nir_add_parameters(struct st_context *st, struct gl_program *prog,
+                              struct gl_shader_program *shader_program)
 {
    nir_shader *nir = prog->nir;
-   struct pipe_screen *screen = st->screen;
 
    /* Make a pass over the IR to add state references for any built-in
     * uniforms that are used.  This has to be done now (during linking).
@@ -275,6 +275,19 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
     * This should be enough for Bitmap and DrawPixels constants.
     */
    _mesa_ensure_and_associate_uniform_storage(st->ctx, shader_program, prog, 28);
+}
+
+/* Second third of converting glsl_to_nir, second part. This lowers and
+ * gathers info on varyings, etc after NIR link time opts have been applied.
+ * It only touches the stage's own program, so the stages of a program can go
+ * through it concurrently.
+ */
+static void
+st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
+                         struct gl_shader_program *shader_program)
+{
+   nir_shader *nir = prog->nir;
+   struct pipe_screen *screen = st->screen;
 
    /* None of the builtins being lowered here can be produced by SPIR-V.  See
     * _mesa_builtin_uniform_desc. Also drivers that support packed uniform
@@ -434,6 +447,67 @@ st_nir_lower_wpos_ytransform(struct nir_shader *nir,
    return progress;
 }
 
+struct st_link_stage_state {
+   struct st_context *st;
+   struct gl_shader_program *shader_program;
+};
+
+static void
+st_lower_linked_stage(struct gl_linked_shader *shader, void *data)
+{
+   struct st_link_stage_state *state = (struct st_link_stage_state *)data;
+   struct st_context *st = state->st;
+   struct gl_context *ctx = st->ctx;
+   struct gl_shader_program *shader_program = state->shader_program;
+   nir_shader *nir = shader->Program->nir;
+   mesa_shader_stage stage = shader->Stage;
+
+   /* Since IO is lowered, we won't need the IO variables from now on.
+    * nir_build_program_resource_list was the last pass that needed them.
+    */
+   NIR_PASS(_, nir, nir_remove_dead_variables,
+            nir_var_shader_in | nir_var_shader_out, NULL);
+
+   /* If there are forms of indirect addressing that the driver
+    * cannot handle, perform the lowering pass.
+    */
+   if (!ctx->screen->shader_caps[stage].indirect_temp_addr ||
+       !ctx->screen->shader_caps[stage].indirect_const_addr) {
+      nir_variable_mode mode = (nir_variable_mode)0;
+
+      mode |= !ctx->screen->shader_caps[stage].indirect_temp_addr ?
+         nir_var_function_temp : (nir_variable_mode)0;
+      mode |= !ctx->screen->shader_caps[stage].indirect_const_addr ?
+         nir_var_uniform | nir_var_mem_ubo | nir_var_mem_ssbo :
+         (nir_variable_mode)0;
+
+      if (mode)
+         nir_lower_indirect_derefs_to_if_else_trees(nir, mode, UINT32_MAX);
+   }
+
+   /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
+    * that the buffer indices are constants in nir where they where
+    * constants in GLSL. */
+   NIR_PASS(_, nir, gl_nir_lower_buffers, shader_program);
+
+   NIR_PASS(_, nir, st_nir_lower_wpos_ytransform, shader->Program,
+            st->screen);
+
+   /* needed to lower base_workgroup_id and base_global_invocation_id */
+   struct nir_lower_compute_system_values_options cs_options = {};
+   NIR_PASS(_, nir, nir_lower_system_values);
+   NIR_PASS(_, nir, nir_lower_compute_system_values, &cs_options);
+}
+
+static void
+st_glsl_to_nir_post_opts_stage(struct gl_linked_shader *shader, void *data)
+{
+   struct st_link_stage_state *state = (struct st_link_stage_state *)data;
+
+   st_glsl_to_nir_post_opts(state->st, shader->Program,
+                            state->shader_program);
+}
+
 static bool
 st_link_glsl_to_nir(struct gl_context *ctx,
                     struct gl_shader_program *shader_program)
@@ -518,56 +592,31 @@ st_link_glsl_to_nir(struct gl_context *ctx,
    nir_build_program_resource_list(&ctx->Const, shader_program,
                                    shader_program->data->spirv);
 
-   for (unsigned i = 0; i < num_shaders; i++) {
-      struct gl_linked_shader *shader = linked_shader[i];
-      nir_shader *nir = shader->Program->nir;
-      mesa_shader_stage stage = shader->Stage;
-
-      /* Since IO is lowered, we won't need the IO variables from now on.
-       * nir_build_program_resource_list was the last pass that needed them.
-       */
-      NIR_PASS(_, nir, nir_remove_dead_variables,
-               nir_var_shader_in | nir_var_shader_out, NULL);
-
-      /* If there are forms of indirect addressing that the driver
-       * cannot handle, perform the lowering pass.
-       */
-      if (!ctx->screen->shader_caps[stage].indirect_temp_addr ||
-          !ctx->screen->shader_caps[stage].indirect_const_addr) {
-         nir_variable_mode mode = (nir_variable_mode)0;
-
-         mode |= !ctx->screen->shader_caps[stage].indirect_temp_addr ?
-            nir_var_function_temp : (nir_variable_mode)0;
-         mode |= !ctx->screen->shader_caps[stage].indirect_const_addr ?
-            nir_var_uniform | nir_var_mem_ubo | nir_var_mem_ssbo :
-            (nir_variable_mode)0;
-
-         if (mode)
-            nir_lower_indirect_derefs_to_if_else_trees(nir, mode, UINT32_MAX);
-      }
-
-      /* This needs to run after the initial pass of nir_lower_vars_to_ssa, so
-       * that the buffer indices are constants in nir where they where
-       * constants in GLSL. */
-      NIR_PASS(_, nir, gl_nir_lower_buffers, shader_program);
+   /* The per-stage lowering below is independent between stages; only
+    * the interface unification after it needs all of them.  SoftFP64
+    * shaders are shared, so they keep the stages on this thread.
+    */
+   struct util_queue *queue =
+      ctx->SoftFP64 ? NULL : link_util_get_stage_queue(ctx);
+   struct st_link_stage_state state = { st, shader_program };
 
-      NIR_PASS(_, nir, st_nir_lower_wpos_ytransform, shader->Program,
-               st->screen);
+   link_util_run_per_stage(queue, linked_shader, num_shaders,
+                           st_lower_linked_stage, &state);
 
-      /* needed to lower base_workgroup_id and base_global_invocation_id */
-      struct nir_lower_compute_system_values_options cs_options = {};
-      NIR_PASS(_, nir, nir_lower_system_values);
-      NIR_PASS(_, nir, nir_lower_compute_system_values, &cs_options);
+   for (unsigned i = 0; i < num_shaders; i++) {
+      st_glsl_to_nir_add_parameters(st, linked_shader[i]->Program,
+                                    shader_program);
    }
 
+   link_util_run_per_stage(queue, linked_shader, num_shaders,
+                           st_glsl_to_nir_post_opts_stage, &state);
+
    struct shader_info *prev_info = NULL;
 
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
       struct shader_info *info = &shader->Program->nir->info;
 
-      st_glsl_to_nir_post_opts(st, shader->Program, shader_program);
-
       if (prev_info &&
           ctx->screen->nir_options[shader->Stage]->unify_interfaces) {
          prev_info->outputs_written |= info->inputs_read &
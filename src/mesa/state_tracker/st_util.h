@@ -36,6 +36,7 @@
 
 
 #include "state_tracker/st_context.h"
+#include "state_tracker/st_debug.h"
 #include "main/context.h"
 
 
@@ -132,9 +133,13 @@ st_validate_state(struct st_context *st, const st_state_bitset pipeline_state_ma
       /* Execute functions that set states that have been changed since
        * the last draw.
        */
-      unsigned i;
-      BITSET_FOREACH_SET(i, dirty, ST_NUM_ATOMS)
-         st->update_functions[i](st);
+      if (unlikely(st->atom_stats)) {
+         st_update_states_profiled(st, dirty);
+      } else {
+         unsigned i;
+         BITSET_FOREACH_SET(i, dirty, ST_NUM_ATOMS)
+            st->update_functions[i](st);
+      }
    }
 }
 
@@ -293,6 +293,13 @@ struct util_queue_monitoring
    unsigned num_direct_items;
    unsigned num_syncs;
    unsigned num_batches;
+
+   /* Monotonic counters that are never reset, so that rates can be computed
+    * from the difference between two samples.
+    */
+   uint64_t total_batches;
+   uint64_t total_batch_bytes;
+   uint64_t total_stall_time_ns; /* time the producer waited for the queue */
 };
 
 #ifdef __cplusplus